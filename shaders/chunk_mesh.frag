@@ -1,27 +1,39 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-#define FOG_SPAN 32.0
+// The fog covers this part of the view distance so that the far terrain fades
+// into the sky
+#define FOG_SPAN_FACTOR 0.25
 #define FOG_COLOR vec3(54.0 / 255.0, 197.0 / 255.0, 244.0 / 255.0)
+// The size of one block tile inside the texture atlas (see block::Server)
+#define TILE_SIZE (16.0 / 512.0)
 
 layout(location = 0) in vec2 frag_uv;
 layout(location = 1) in vec3 frag_pos;
 layout(location = 2) in vec3 frag_eye_pos;
 layout(location = 3) in float frag_light_value;
+layout(location = 4) flat in vec2 frag_tile;
 
 layout(location = 0) out vec4 out_color;
 
 layout(binding = 1) uniform sampler2D chunk_mesh_texture;
-layout(push_constant) uniform PushConstants { float fog_max_distance; }
+layout(push_constant) uniform PushConstants {
+  float fog_max_distance;
+}
 pushies;
 
 void main() {
-  vec4 texture_color = texture(chunk_mesh_texture, frag_uv);
+  // Repeat the tile across merged faces. The gradients are computed from the
+  // continuous uv to avoid mip map artifacts at the tile borders
+  vec2 tile_uv = frag_tile + fract(frag_uv) * TILE_SIZE;
+  vec4 texture_color =
+      textureGrad(chunk_mesh_texture, tile_uv, dFdx(frag_uv) * TILE_SIZE,
+                  dFdy(frag_uv) * TILE_SIZE);
 
   // Fog calculation
   float frag_distance = length(vec2(frag_pos.x, frag_pos.z) -
                                vec2(frag_eye_pos.x, frag_eye_pos.z));
-  float fog_min_distance = pushies.fog_max_distance - FOG_SPAN;
+  float fog_min_distance = pushies.fog_max_distance * (1.0 - FOG_SPAN_FACTOR);
   float fog_amount = (frag_distance - fog_min_distance) /
                      (pushies.fog_max_distance - fog_min_distance);
   fog_amount = clamp(fog_amount, 0.0, 1.0);
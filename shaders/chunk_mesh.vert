@@ -1,14 +1,28 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(location = 0) in vec3 in_position;
-layout(location = 1) in vec2 in_uv;
-layout(location = 2) in float in_light_value;
+// The size of one block tile inside the texture atlas (see block::Server)
+#define TILE_SIZE (16.0 / 512.0)
+#define TILES_PER_ROW 32u
+
+#define FACE_FRONT 0u
+#define FACE_BACK 1u
+#define FACE_LEFT 2u
+#define FACE_RIGHT 3u
+#define FACE_TOP 4u
+#define FACE_BOT 5u
+
+// x:  x (5 bits) | y (8 bits) | z (5 bits) | face (3 bits) | light (4 bits)
+// y:  tile index
+layout(location = 0) in uvec2 in_data;
+// The world position of the chunk. It is read once per draw
+layout(location = 1) in ivec2 in_chunk_origin;
 
 layout(location = 0) out vec2 frag_uv;
 layout(location = 1) out vec3 frag_pos;
 layout(location = 2) out vec3 frag_eye_pos;
 layout(location = 3) out float frag_light_value;
+layout(location = 4) flat out vec2 frag_tile;
 
 layout(binding = 0) uniform Global {
   mat4 proj_view;
@@ -17,9 +31,42 @@ layout(binding = 0) uniform Global {
 global;
 
 void main() {
-  gl_Position = global.proj_view * vec4(in_position, 1.0);
-  frag_uv = in_uv;
-  frag_pos = in_position;
+  vec3 local_pos = vec3(float(in_data.x & 31u), float((in_data.x >> 5) & 255u),
+                        float((in_data.x >> 13) & 31u));
+  uint face = (in_data.x >> 18) & 7u;
+  uint light = (in_data.x >> 21) & 15u;
+
+  // The texture coordinates in number of tiles. They are derived from the
+  // position so that the tile repeats for every block of a merged face
+  switch (face) {
+  case FACE_FRONT:
+    frag_uv = vec2(local_pos.x, -local_pos.y);
+    break;
+  case FACE_BACK:
+    frag_uv = vec2(local_pos.x, local_pos.y);
+    break;
+  case FACE_LEFT:
+    frag_uv = vec2(local_pos.y, local_pos.z);
+    break;
+  case FACE_RIGHT:
+    frag_uv = vec2(-local_pos.y, local_pos.z);
+    break;
+  case FACE_TOP:
+    frag_uv = vec2(local_pos.x, local_pos.z);
+    break;
+  default:
+    frag_uv = vec2(local_pos.x, -local_pos.z);
+    break;
+  }
+
+  vec3 position = local_pos + vec3(float(in_chunk_origin.x), 0.0,
+                                   float(in_chunk_origin.y));
+
+  gl_Position = global.proj_view * vec4(position, 1.0);
+  frag_pos = position;
   frag_eye_pos = global.eye_pos;
-  frag_light_value = in_light_value;
+  frag_light_value = float(light) / 15.0;
+  frag_tile = vec2(float(in_data.y % TILES_PER_ROW),
+                   float(in_data.y / TILES_PER_ROW)) *
+              TILE_SIZE;
 }
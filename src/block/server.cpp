@@ -3,21 +3,15 @@
 namespace block {
 
 Server::Server() {
-
-  // tex_coords.x ...... left
-  // tex_coords.y ...... top
-  // tex_coords.z ...... right
-  // tex_coords.w ...... bot
-
   // Grass
   {
     BlockData data;
-    data.tex_coords.front = _block_tex_coords(1, 2);
-    data.tex_coords.back = _block_tex_coords(1, 0);
-    data.tex_coords.left = _block_tex_coords(0, 1);
-    data.tex_coords.right = _block_tex_coords(2, 1);
-    data.tex_coords.bot = _block_tex_coords(1, 3);
-    data.tex_coords.top = _block_tex_coords(1, 1);
+    data.tiles.front = _block_tile(1, 2);
+    data.tiles.back = _block_tile(1, 0);
+    data.tiles.left = _block_tile(0, 1);
+    data.tiles.right = _block_tile(2, 1);
+    data.tiles.bot = _block_tile(1, 3);
+    data.tiles.top = _block_tile(1, 1);
 
     m_block_data.emplace(Type::GRASS, std::move(data));
   }
@@ -26,12 +20,12 @@ Server::Server() {
   {
     BlockData data;
 
-    data.tex_coords.front = _block_tex_coords(4, 2);
-    data.tex_coords.back = _block_tex_coords(4, 0);
-    data.tex_coords.left = _block_tex_coords(3, 1);
-    data.tex_coords.right = _block_tex_coords(5, 1);
-    data.tex_coords.bot = _block_tex_coords(4, 3);
-    data.tex_coords.top = _block_tex_coords(4, 1);
+    data.tiles.front = _block_tile(4, 2);
+    data.tiles.back = _block_tile(4, 0);
+    data.tiles.left = _block_tile(3, 1);
+    data.tiles.right = _block_tile(5, 1);
+    data.tiles.bot = _block_tile(4, 3);
+    data.tiles.top = _block_tile(4, 1);
 
     m_block_data.emplace(Type::DIRT, std::move(data));
   }
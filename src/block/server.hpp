@@ -16,40 +16,34 @@ public:
     }
   }
 
-  struct TextureCoordinates {
-    glm::vec4 front;
-    glm::vec4 back;
-    glm::vec4 left;
-    glm::vec4 right;
-    glm::vec4 bot;
-    glm::vec4 top;
+  // The indices of the tiles inside of the block texture atlas
+  struct TextureTiles {
+    uint32_t front;
+    uint32_t back;
+    uint32_t left;
+    uint32_t right;
+    uint32_t bot;
+    uint32_t top;
   };
 
+  // How many tiles are stored in one row of the block texture atlas
+  static constexpr uint32_t tiles_per_row = 32;
+
   Server();
 
-  inline const TextureCoordinates &
-  get_texture_coordinates(const Type type) const {
-    return m_block_data.at(type).tex_coords;
+  inline const TextureTiles &get_texture_tiles(const Type type) const {
+    return m_block_data.at(type).tiles;
   }
 
 private:
-  static constexpr float block_texture_size = 512.0f;
-  static constexpr float block_pixel_size = 16.0f;
-
-  // Returns the uv texture coordinates for the block at horizontal x position
-  // and vertical y position
-  static constexpr glm::vec4 _block_tex_coords(int x, int y) {
-    constexpr auto ps2 = 0.0f;
-    return glm::vec4(
-        static_cast<float>(x) * block_pixel_size / block_texture_size + ps2,
-        static_cast<float>(y) * block_pixel_size / block_texture_size + ps2,
-        static_cast<float>(x + 1) * block_pixel_size / block_texture_size - ps2,
-        static_cast<float>(y + 1) * block_pixel_size / block_texture_size -
-            ps2);
+  // Returns the tile index for the block at horizontal x position and vertical
+  // y position of the block texture atlas
+  static constexpr uint32_t _block_tile(uint32_t x, uint32_t y) {
+    return x + y * tiles_per_row;
   }
 
   struct BlockData {
-    TextureCoordinates tex_coords;
+    TextureTiles tiles;
   };
 
   std::map<Type, BlockData> m_block_data;
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 namespace block {
 
@@ -12,6 +13,21 @@ enum Light {
   STEPS = 10,
 };
 
+// Returns wether no light can pass through a block of type t
+constexpr bool is_opaque(const Type t) { return t != Type::AIR; }
+
+// Returns the level of the block light which a block of type t emits. It is
+// between 0 and 15
+constexpr uint8_t get_light_emission(const Type t) {
+  switch (t) {
+  case Type::AIR:
+  case Type::GRASS:
+  case Type::DIRT:
+  default:
+    return 0;
+  }
+}
+
 constexpr const char *type_as_str(const Type t) {
   switch (t) {
   case Type::AIR:
@@ -1,196 +1,139 @@
 #include "block.hpp"
 
 namespace chunk {
-Vertex::Vertex(float x, float y, float z, float u, float v, float _light)
-    : position(x, y, z), uv(u, v), light(_light) {}
+Vertex::Vertex(uint32_t x, uint32_t y, uint32_t z, uint32_t face,
+               uint32_t light, uint32_t tile)
+    : data(x | (y << 5) | (z << 13) | (face << 18) | (light << 21), tile) {}
 
 Block::Block()
-    : type(block::Type::AIR), m_faces(0),
-      m_light(1 | (1 << 4) | (1 << 8) | (1 << 12) | (1 << 16) | (1 << 20)) {}
+    : m_data(1 | (1 << 4) | (1 << 8) | (1 << 12) | (1 << 16) | (1 << 20)) {}
 
-void Block::generate(const block::Server &block_server,
+void Block::generate(const block::Server &block_server, const block::Type type,
                      std::vector<Vertex> &vertices,
-                     std::vector<uint32_t> &indices,
-                     const glm::vec3 &position) const {
-  const auto &tex_coords = block_server.get_texture_coordinates(type);
-
-  _create_cube(vertices, indices, position, tex_coords, front_light(),
-               back_light(), left_light(), right_light(), top_light(),
-               bot_light(), front_face(), back_face(), left_face(),
-               right_face(), top_face(), bot_face());
+                     const glm::ivec3 &position) const {
+  const auto &tiles = block_server.get_texture_tiles(type);
+
+  _create_cube(vertices, position, tiles, front_light(), back_light(),
+               left_light(), right_light(), top_light(), bot_light(),
+               front_face(), back_face(), left_face(), right_face(),
+               top_face(), bot_face());
 }
 
 physics::AABB Block::to_aabb(const glm::vec3 &position) const {
   return physics::AABB(position.x, position.y, position.z, 1.0f, 1.0f, 1.0f);
 }
 
-void Block::_create_cube(std::vector<Vertex> &vertices,
-                         std::vector<uint32_t> &indices, const glm::vec3 &p,
-                         const block::Server::TextureCoordinates &tex_coords,
+void Block::create_face(std::vector<Vertex> &vertices, const Face face,
+                        const glm::ivec3 &a, const glm::ivec3 &b,
+                        const uint32_t tile, const float light) {
+  const auto l{static_cast<uint32_t>(light * static_cast<float>(0b1111) +
+                                     0.5f)};
+
+  // The vertices of every face are ordered so that face_indices keeps the
+  // winding of the triangles the same for all faces
+  switch (face) {
+  case Face::FRONT:
+    vertices.emplace_back(a.x, a.y, b.z, face, l, tile);
+    vertices.emplace_back(b.x, a.y, b.z, face, l, tile);
+    vertices.emplace_back(b.x, b.y, b.z, face, l, tile);
+    vertices.emplace_back(a.x, b.y, b.z, face, l, tile);
+    break;
+  case Face::BACK:
+    vertices.emplace_back(b.x, a.y, a.z, face, l, tile);
+    vertices.emplace_back(a.x, a.y, a.z, face, l, tile);
+    vertices.emplace_back(a.x, b.y, a.z, face, l, tile);
+    vertices.emplace_back(b.x, b.y, a.z, face, l, tile);
+    break;
+  case Face::RIGHT:
+    vertices.emplace_back(b.x, a.y, b.z, face, l, tile);
+    vertices.emplace_back(b.x, a.y, a.z, face, l, tile);
+    vertices.emplace_back(b.x, b.y, a.z, face, l, tile);
+    vertices.emplace_back(b.x, b.y, b.z, face, l, tile);
+    break;
+  case Face::LEFT:
+    vertices.emplace_back(a.x, a.y, a.z, face, l, tile);
+    vertices.emplace_back(a.x, a.y, b.z, face, l, tile);
+    vertices.emplace_back(a.x, b.y, b.z, face, l, tile);
+    vertices.emplace_back(a.x, b.y, a.z, face, l, tile);
+    break;
+  case Face::TOP:
+    vertices.emplace_back(a.x, b.y, b.z, face, l, tile);
+    vertices.emplace_back(b.x, b.y, b.z, face, l, tile);
+    vertices.emplace_back(b.x, b.y, a.z, face, l, tile);
+    vertices.emplace_back(a.x, b.y, a.z, face, l, tile);
+    break;
+  case Face::BOT:
+    vertices.emplace_back(a.x, a.y, a.z, face, l, tile);
+    vertices.emplace_back(b.x, a.y, a.z, face, l, tile);
+    vertices.emplace_back(b.x, a.y, b.z, face, l, tile);
+    vertices.emplace_back(a.x, a.y, b.z, face, l, tile);
+    break;
+  }
+}
+
+void Block::_create_cube(std::vector<Vertex> &vertices, const glm::ivec3 &p,
+                         const block::Server::TextureTiles &tiles,
                          const float front_light, const float back_light,
                          const float left_light, const float right_light,
                          const float top_light, const float bot_light,
                          const bool front_face, const bool back_face,
                          const bool left_face, const bool right_face,
                          const bool top_face, const bool bot_face) {
-  if (!(front_face || back_face || left_face || right_face || top_face ||
-        bot_face))
-    return;
+  const glm::ivec3 &from(p);
+  const glm::ivec3 to(p + 1);
 
   if (front_face) {
-    const auto i{vertices.size()};
-    vertices.reserve(vertices.size() + vertices_per_face);
-
-    vertices.emplace_back(p.x + -0.5f, p.y + -0.5f, p.z + 0.5f,
-                          tex_coords.front.x, tex_coords.front.w,
-                          front_light); // 0
-    vertices.emplace_back(p.x + 0.5f, p.y + -0.5f, p.z + 0.5f,
-                          tex_coords.front.z, tex_coords.front.w,
-                          front_light); // 1
-    vertices.emplace_back(p.x + 0.5f, p.y + 0.5f, p.z + 0.5f,
-                          tex_coords.front.z, tex_coords.front.y,
-                          front_light); // 2
-    vertices.emplace_back(p.x + -0.5f, p.y + 0.5f, p.z + 0.5f,
-                          tex_coords.front.x, tex_coords.front.y,
-                          front_light); // 3
-
-    indices.reserve(indices.size() + indices_per_face);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 0);
+    create_face(vertices, Face::FRONT,
+                glm::ivec3(from.x, from.y, to.z), to, tiles.front, front_light);
   }
-
   if (back_face) {
-    const auto i{vertices.size()};
-    vertices.reserve(vertices.size() + vertices_per_face);
-
-    vertices.emplace_back(p.x + -0.5f, p.y + -0.5f, p.z + -0.5f,
-                          tex_coords.back.x, tex_coords.back.y,
-                          back_light); // 4
-    vertices.emplace_back(p.x + 0.5f, p.y + -0.5f, p.z + -0.5f,
-                          tex_coords.back.z, tex_coords.back.y,
-                          back_light); // 5
-    vertices.emplace_back(p.x + 0.5f, p.y + 0.5f, p.z + -0.5f,
-                          tex_coords.back.z, tex_coords.back.w,
-                          back_light); // 6
-    vertices.emplace_back(p.x + -0.5f, p.y + 0.5f, p.z + -0.5f,
-                          tex_coords.back.x, tex_coords.back.w,
-                          back_light); // 7
-
-    indices.reserve(indices.size() + indices_per_face);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 1);
+    create_face(vertices, Face::BACK, from,
+                glm::ivec3(to.x, to.y, from.z), tiles.back, back_light);
   }
-
   if (right_face) {
-    const auto i{vertices.size()};
-    vertices.reserve(vertices.size() + vertices_per_face);
-
-    vertices.emplace_back(p.x + 0.5f, p.y + 0.5f, p.z + -0.5f,
-                          tex_coords.right.x, tex_coords.right.y,
-                          right_light); // 10
-    vertices.emplace_back(p.x + 0.5f, p.y + -0.5f, p.z + 0.5f,
-                          tex_coords.right.z, tex_coords.right.w,
-                          right_light); // 13
-    vertices.emplace_back(p.x + 0.5f, p.y + -0.5f, p.z + -0.5f,
-                          tex_coords.right.z, tex_coords.right.y,
-                          right_light); // 16
-    vertices.emplace_back(p.x + 0.5f, p.y + 0.5f, p.z + 0.5f,
-                          tex_coords.right.x, tex_coords.right.w,
-                          right_light); // 17
-
-    indices.reserve(indices.size() + indices_per_face);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 1);
+    create_face(vertices, Face::RIGHT,
+                glm::ivec3(to.x, from.y, from.z), to, tiles.right, right_light);
   }
-
   if (left_face) {
-    const auto i{vertices.size()};
-    vertices.reserve(vertices.size() + vertices_per_face);
-
-    vertices.emplace_back(p.x + -0.5f, p.y + 0.5f, p.z + -0.5f,
-                          tex_coords.left.z, tex_coords.left.y,
-                          left_light); // 11
-    vertices.emplace_back(p.x + -0.5f, p.y + -0.5f, p.z + 0.5f,
-
-                          tex_coords.left.x, tex_coords.left.w,
-                          left_light); // 12
-    vertices.emplace_back(p.x + -0.5f, p.y + -0.5f, p.z + -0.5f,
-                          tex_coords.left.x, tex_coords.left.y,
-                          left_light); // 18
-    vertices.emplace_back(p.x + -0.5f, p.y + 0.5f, p.z + 0.5f,
-                          tex_coords.left.z, tex_coords.left.w,
-                          left_light); // 19
-
-    indices.reserve(indices.size() + indices_per_face);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 2);
+    create_face(vertices, Face::LEFT, from,
+                glm::ivec3(from.x, to.y, to.z), tiles.left, left_light);
   }
-
   if (top_face) {
-    const auto i{vertices.size()};
-    vertices.reserve(vertices.size() + vertices_per_face);
-
-    vertices.emplace_back(p.x + -0.5f, p.y + 0.5f, p.z + 0.5f, tex_coords.top.x,
-                          tex_coords.top.w, top_light); // 8
-    vertices.emplace_back(p.x + 0.5f, p.y + 0.5f, p.z + 0.5f, tex_coords.top.z,
-                          tex_coords.top.w, top_light); // 9
-    vertices.emplace_back(p.x + 0.5f, p.y + 0.5f, p.z + -0.5f, tex_coords.top.z,
-                          tex_coords.top.y, top_light); // 10
-    vertices.emplace_back(p.x + -0.5f, p.y + 0.5f, p.z + -0.5f,
-                          tex_coords.top.x, tex_coords.top.y, top_light); // 11
-
-    indices.reserve(indices.size() + 6);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 0);
+    create_face(vertices, Face::TOP, glm::ivec3(from.x, to.y, from.z),
+                to, tiles.top, top_light);
   }
-
   if (bot_face) {
-    const auto i{vertices.size()};
-    vertices.reserve(vertices.size() + vertices_per_face);
-
-    vertices.emplace_back(p.x + -0.5f, p.y + -0.5f, p.z + 0.5f,
-                          tex_coords.bot.x, tex_coords.bot.y, bot_light); // 12
-    vertices.emplace_back(p.x + 0.5f, p.y + -0.5f, p.z + 0.5f, tex_coords.bot.z,
-                          tex_coords.bot.y, bot_light); // 13
-    vertices.emplace_back(p.x + 0.5f, p.y + -0.5f, p.z + -0.5f,
-                          tex_coords.bot.z, tex_coords.bot.w, bot_light); // 14
-    vertices.emplace_back(p.x + -0.5f, p.y + -0.5f, p.z + -0.5f,
-                          tex_coords.bot.x, tex_coords.bot.w, bot_light); // 15
-
-    indices.reserve(indices.size() + indices_per_face);
-    indices.emplace_back(i + 3);
-    indices.emplace_back(i + 2);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 1);
-    indices.emplace_back(i + 0);
-    indices.emplace_back(i + 3);
+    create_face(vertices, Face::BOT, from,
+                glm::ivec3(to.x, from.y, to.z), tiles.bot, bot_light);
   }
 }
 
+Section::Section()
+    : m_types(block_count, block::Type::AIR), m_non_air_count(0) {}
+
+void Section::set(const size_t index, const block::Type value) {
+  const auto old_value{m_types.get(index)};
+  if (old_value == value) {
+    return;
+  }
+
+  m_non_air_count += (old_value == block::Type::AIR);
+  m_non_air_count -= (value == block::Type::AIR);
+  m_types.set(index, value);
+}
+
+void Section::fill(const block::Type value) {
+  m_types.fill(value);
+  m_non_air_count = (value != block::Type::AIR) * block_count;
+}
+
 void BlockArray::fill(const block::Type value) {
-  for (auto &b : m_array) {
-    b.type = value;
+  for (auto &s : m_sections) {
+    s.fill(value);
   }
+  m_columns.fill(value == block::Type::AIR ? ColumnMask()
+                                           : ColumnMask::full());
+  m_heights.fill(value == block::Type::AIR ? 0 : block_height);
 }
 
 void BlockArray::half_fill(const block::Type value) {
@@ -224,16 +167,33 @@ BlockArray::to_stored_blocks() const {
 void BlockArray::from_stored_blocks(
     const std::array<uint8_t, block_width * block_depth * block_height>
         &stored_blocks) {
-  for (int x = 0; x < block_width; x++) {
-    for (int z = 0; z < block_depth; z++) {
-      for (int y = 0; y < block_height; y++) {
-        set(x, y, z,
-            static_cast<block::Type>(
-                stored_blocks[x + z * block_width +
-                              y * (block_width * block_depth)]));
-      }
+  // The stored blocks use the same layout as the sections so they can be
+  // copied section by section
+  for (size_t s = 0; s < section_count; s++) {
+    auto &section{m_sections[s]};
+    const auto *section_blocks{&stored_blocks[s * Section::block_count]};
+
+    section.fill(static_cast<block::Type>(section_blocks[0]));
+    for (size_t i = 0; i < Section::block_count; i++) {
+      const auto type{static_cast<block::Type>(section_blocks[i])};
+      section.set(i, type);
+      m_columns[i % (block_width * block_depth)].set(
+          s * section_height + i / (block_width * block_depth),
+          type != block::Type::AIR);
     }
   }
+
+  for (size_t i = 0; i < m_heights.size(); i++) {
+    m_heights[i] = static_cast<uint8_t>(m_columns[i].height());
+  }
+}
+
+size_t BlockArray::memory_usage() const {
+  size_t memory{sizeof(m_array) + sizeof(m_columns) + sizeof(m_heights)};
+  for (const auto &s : m_sections) {
+    memory += s.memory_usage();
+  }
+  return memory;
 }
 
 } // namespace chunk
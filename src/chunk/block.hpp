@@ -2,7 +2,10 @@
 #include "../block/server.hpp"
 #include "../block/type.hpp"
 #include "../physics/aabb.hpp"
+#include "column_mask.hpp"
+#include "palette_array.hpp"
 #include <array>
+#include <bitset>
 #include <glm/glm.hpp>
 #include <limits>
 #include <vector>
@@ -12,20 +15,44 @@ namespace chunk {
 constexpr int block_width = 16;
 constexpr int block_depth = 16;
 constexpr int block_height = 128;
+// Chunks are split vertically into sections of this height
+constexpr int section_height = 16;
+constexpr int section_count = block_height / section_height;
 
+// Selects a subset of the sections of a chunk
+using SectionMask = std::bitset<section_count>;
+
+static_assert(block_height == ColumnMask::bit_count,
+              "a column of a chunk needs to fit into a ColumnMask");
+
+// Returns wether the block at the given position inside of a chunk does not
+// touch the border of its section
+constexpr bool is_inner_section_block(const size_t x, const size_t y,
+                                      const size_t z) {
+  return x != 0 && x != block_width - 1 && z != 0 && z != block_depth - 1 &&
+         y % section_height != 0 && y % section_height != section_height - 1;
+}
+
+// A vertex of a chunk mesh packed into 8 bytes. The position is relative to
+// the chunk. The texture coordinates are computed in the vertex shader from
+// the position and the face
+// data.x ... x (5 bits) | y (8 bits) | z (5 bits) | face (3 bits) | light (4
+//            bits)
+// data.y ... index of the tile inside of the block texture atlas
 class Vertex {
 public:
-  Vertex(float x, float y, float z, float u, float v, float light);
+  Vertex(uint32_t x, uint32_t y, uint32_t z, uint32_t face, uint32_t light,
+         uint32_t tile);
 
-  glm::vec3 position;
-  glm::vec2 uv;
-  float light;
+  glm::uvec2 data;
 };
 struct GlobalUniform {
   glm::mat4 proj_view;
   glm::vec3 eye_pos;
 };
 
+// Stores the faces and the light of a block. The type of the block is stored
+// separately inside of BlockArray
 class Block {
 public:
   static constexpr size_t default_face_count =
@@ -33,6 +60,19 @@ public:
       (block_height * block_depth) * 2;
   static constexpr size_t vertices_per_face = 4;
   static constexpr size_t indices_per_face = 6;
+  // The indices of the vertices of one face. Every face uses the same pattern
+  // so that all faces share one index buffer
+  static constexpr std::array<uint16_t, indices_per_face> face_indices{
+      0, 1, 2, 2, 3, 0};
+
+  enum Face {
+    FRONT,
+    BACK,
+    LEFT,
+    RIGHT,
+    TOP,
+    BOT,
+  };
 
   Block();
 
@@ -57,6 +97,13 @@ public:
   }
   constexpr void top_face(const bool value) { _set_face(top_face_bit, value); }
   constexpr void bot_face(const bool value) { _set_face(bot_face_bit, value); }
+  constexpr void set_faces(const bool front, const bool back, const bool left,
+                           const bool right, const bool top, const bool bot) {
+    m_data = (m_data & ~all_faces_bits) | (front_face_bit * front) |
+             (back_face_bit * back) | (left_face_bit * left) |
+             (right_face_bit * right) | (top_face_bit * top) |
+             (bot_face_bit * bot);
+  }
 
   constexpr float front_light() const { return _get_light(front_light_bit); }
   constexpr float back_light() const { return _get_light(back_light_bit); }
@@ -84,22 +131,29 @@ public:
     _set_light(bot_light_bit, value);
   }
 
-  void generate(const block::Server &block_server,
-                std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
-                const glm::vec3 &position) const;
+  void generate(const block::Server &block_server, const block::Type type,
+                std::vector<Vertex> &vertices,
+                const glm::ivec3 &position) const;
   physics::AABB to_aabb(const glm::vec3 &position) const;
 
-  inline operator bool() const { return type != block::Type::AIR; }
-
-  block::Type type;
+  // Creates a quad spanning from the from position to the to position relative
+  // to the chunk. One component of from and to needs to be the same depending
+  // on the face. The tile gets repeated for every block covered by the quad
+  static void create_face(std::vector<Vertex> &vertices, const Face face,
+                          const glm::ivec3 &from, const glm::ivec3 &to,
+                          const uint32_t tile, const float light);
 
 private:
-  static constexpr uint8_t front_face_bit = 1 << 0;
-  static constexpr uint8_t back_face_bit = 1 << 1;
-  static constexpr uint8_t left_face_bit = 1 << 2;
-  static constexpr uint8_t right_face_bit = 1 << 3;
-  static constexpr uint8_t top_face_bit = 1 << 4;
-  static constexpr uint8_t bot_face_bit = 1 << 5;
+  // The light values use the lower 24 bits and the faces the upper 8 bits
+  static constexpr uint32_t front_face_bit = 1 << 24;
+  static constexpr uint32_t back_face_bit = 1 << 25;
+  static constexpr uint32_t left_face_bit = 1 << 26;
+  static constexpr uint32_t right_face_bit = 1 << 27;
+  static constexpr uint32_t top_face_bit = 1 << 28;
+  static constexpr uint32_t bot_face_bit = 1 << 29;
+  static constexpr uint32_t all_faces_bits =
+      front_face_bit | back_face_bit | left_face_bit | right_face_bit |
+      top_face_bit | bot_face_bit;
 
   static constexpr uint8_t light_bits_per_face = 4;
   static constexpr uint32_t front_light_bit = 0;
@@ -110,9 +164,8 @@ private:
   static constexpr uint32_t bot_light_bit = light_bits_per_face * 5;
 
   static void
-  _create_cube(std::vector<Vertex> &vertices, std::vector<uint32_t> &indices,
-               const glm::vec3 &position,
-               const block::Server::TextureCoordinates &tex_coords,
+  _create_cube(std::vector<Vertex> &vertices, const glm::ivec3 &position,
+               const block::Server::TextureTiles &tiles,
                const float front_light = 1.0f, const float back_light = 1.0f,
                const float left_light = 1.0f, const float right_light = 1.0f,
                const float top_light = 1.0f, const float bot_light = 1.0f,
@@ -120,29 +173,65 @@ private:
                const bool left_face = true, const bool right_face = true,
                const bool top_face = true, const bool bot_face = true);
 
-  constexpr bool _get_face(const uint8_t bit) const {
-    return (m_faces & bit) == bit;
+  constexpr bool _get_face(const uint32_t bit) const {
+    return (m_data & bit) == bit;
   }
-  constexpr void _set_face(const uint8_t bit, const bool value) {
-    m_faces = m_faces & (~bit * !value + ~0 * value) | (bit * value);
+  constexpr void _set_face(const uint32_t bit, const bool value) {
+    m_data = m_data & (~bit * !value + ~0u * value) | (bit * value);
   }
 
   constexpr float _get_light(const uint32_t bit) const {
-    const auto int_value{(m_light >> bit) & 0b1111};
+    const auto int_value{(m_data >> bit) & 0b1111};
     return static_cast<float>(int_value) / static_cast<float>(0b1111);
   }
 
   constexpr void _set_light(const uint32_t bit, const float value) {
     const auto int_value{
         static_cast<uint32_t>(value * static_cast<float>(0b1111))};
-    m_light &= ~(0b1111 << bit);
-    m_light |= int_value << bit;
+    m_data &= ~(0b1111u << bit);
+    m_data |= int_value << bit;
   }
 
-  uint8_t m_faces;
-  uint32_t m_light;
+  uint32_t m_data;
 };
 
+// Stores the block types of a 16x16x16 part of a chunk and keeps track of how
+// many of them are not air
+class Section {
+public:
+  static constexpr size_t block_count =
+      block_width * block_depth * section_height;
+  // The most faces the mesh of a section can have. Every face lies between a
+  // block and air. At most half of the blocks can be surrounded by air inside
+  // of the section and the faces on its border can face the neighbours
+  static constexpr size_t max_face_count =
+      block_count / 2 * 6 + (block_width * block_depth) * 2 +
+      (section_height * block_width) * 2 + (section_height * block_depth) * 2;
+
+  Section();
+
+  inline block::Type get(const size_t index) const {
+    return m_types.get(index);
+  }
+  void set(const size_t index, const block::Type value);
+  void fill(const block::Type value);
+
+  // Returns wether all blocks are air
+  inline bool is_empty() const { return m_non_air_count == 0; }
+  // Returns wether no block is air
+  inline bool is_full() const { return m_non_air_count == block_count; }
+  inline size_t get_non_air_count() const { return m_non_air_count; }
+  inline size_t memory_usage() const { return m_types.memory_usage(); }
+
+private:
+  PaletteArray m_types;
+  size_t m_non_air_count;
+};
+
+// Stores the blocks of a chunk. The types are stored palette compressed in
+// vertical sections and the faces and light of each block are stored in a
+// separate array. Additionally a bitmask of the non air blocks and the height
+// of the highest non air block are kept for every column
 class BlockArray {
 public:
   void fill(const block::Type value = block::Type::GRASS);
@@ -150,7 +239,26 @@ public:
   void clear();
 
   inline block::Type get(const size_t x, const size_t y, const size_t z) const {
-    return m_array[_index(x, y, z)].type;
+    return m_sections[y / section_height].get(_section_index(x, y, z));
+  }
+
+  inline const Section &get_section(const size_t index) const {
+    return m_sections[index];
+  }
+  // Returns the section containing the block at height y
+  inline const Section &get_section_at(const size_t y) const {
+    return m_sections[y / section_height];
+  }
+
+  // Returns the bitmask of all non air blocks of the column at x and z
+  inline const ColumnMask &get_column(const size_t x, const size_t z) const {
+    return m_columns[x + z * block_width];
+  }
+  // Returns the height of the highest non air block of the column at x and z
+  // plus one or 0 if the column only contains air. Every non air block is
+  // opaque, so no sun light reaches the column below this height
+  inline size_t get_column_height(const size_t x, const size_t z) const {
+    return m_heights[x + z * block_width];
   }
 
   inline Block &get_block(const size_t x, const size_t y, const size_t z) {
@@ -164,7 +272,10 @@ public:
 
   inline void set(const size_t x, const size_t y, const size_t z,
                   const block::Type value) {
-    m_array[_index(x, y, z)].type = value;
+    m_sections[y / section_height].set(_section_index(x, y, z), value);
+    auto &column{m_columns[x + z * block_width]};
+    column.set(y, value != block::Type::AIR);
+    m_heights[x + z * block_width] = static_cast<uint8_t>(column.height());
   }
 
   std::array<uint8_t, block_width * block_depth * block_height>
@@ -173,11 +284,23 @@ public:
       const std::array<uint8_t, block_width * block_depth * block_height>
           &stored_blocks);
 
+  // Returns the amount of bytes used to store the blocks
+  size_t memory_usage() const;
+
 private:
   static inline size_t _index(const size_t x, const size_t y, const size_t z) {
     return x + z * block_width + y * (block_width * block_depth);
   }
+  static inline size_t _section_index(const size_t x, const size_t y,
+                                      const size_t z) {
+    return x + z * block_width +
+           (y % section_height) * (block_width * block_depth);
+  }
 
+  std::array<Section, section_count> m_sections;
+  std::array<ColumnMask, block_width * block_depth> m_columns;
+  // The heightmap of the chunk. It is derived from m_columns
+  std::array<uint8_t, block_width * block_depth> m_heights{};
   std::array<Block, block_width * block_depth * block_height> m_array;
 };
 } // namespace chunk
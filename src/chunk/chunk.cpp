@@ -1,79 +1,125 @@
 #include "chunk.hpp"
+#include "../core/profiler.hpp"
 #include <algorithm>
 #ifndef NDEBUG
 #include "../core/log.hpp"
 #endif
 
 namespace chunk {
-Chunk::Chunk(const ::core::vulkan::Context &context, const glm::ivec2 &position)
-    : m_mesh(context), m_position(position), m_needs_face_update(false),
-      m_vertices_ready(false), m_generating(false) {}
+Chunk::Chunk(::core::vulkan::BufferArena &mesh_arena,
+             ::core::JobSystem &job_system, const glm::ivec2 &position,
+             const Mesh::Mode mesh_mode)
+    : Chunk(job_system, position, mesh_mode) {
+  m_mesh_buffer = std::make_unique<MeshBuffer>(mesh_arena);
+}
+
+Chunk::Chunk(::core::JobSystem &job_system, const glm::ivec2 &position,
+             const Mesh::Mode mesh_mode)
+    : m_position(position), m_needs_face_update(false),
+      m_job_system(job_system), m_vertices_ready(false), m_relit_sections(0) {
+  m_mesh.set_mode(mesh_mode);
+}
 
 Chunk::~Chunk() {
-  if (m_generating) {
-    m_generate_thread->join();
-    m_generating = false;
-    m_generate_thread.reset();
+  // A failed job has already been logged by the worker
+  try {
+    m_generate_job.wait();
+  } catch (...) {
   }
 }
 
-void Chunk::generate(const block::Server &block_server,
-                     const bool multi_thread) {
-  if (m_generating) {
-    m_generate_thread->join();
-    m_generating = false;
-    m_generate_thread.reset();
+::core::JobSystem::Handle
+Chunk::generate(const block::Server &block_server, const bool multi_thread,
+                const SectionMask &sections,
+                const ::core::JobSystem::Priority priority) {
+  VULKANKRAFT_PROFILE_ZONE("Chunk::generate");
+  m_generate_job.wait();
+
+  // Discard the vertices of a previous generation which have not been uploaded
+  // yet. The vertices of the other sections are still uploaded, but not before
+  // the new job has finished since it writes to the same mesh
+  if (m_vertices_ready) {
+    m_mesh.clear_vertices(sections);
   }
+  m_vertices_ready = false;
 
   if (!multi_thread) {
     if (m_needs_face_update) {
       update_faces();
       m_needs_face_update = false;
     }
-    m_mesh.generate_vertices(block_server, this, m_position);
-    m_mesh.load_buffer();
-    return;
-  }
-
-  m_generate_thread = std::make_unique<std::thread>([&]() {
-    if (m_needs_face_update) {
-      update_faces();
-      m_needs_face_update = false;
+    m_mesh.generate_vertices(block_server, this, sections);
+    if (m_mesh_buffer) {
+      m_mesh_buffer->load(m_mesh);
     }
+    return ::core::JobSystem::Handle();
+  }
 
-    m_mesh.generate_vertices(block_server, this, m_position);
+  m_generate_job = m_job_system.submit(
+      [&, sections]() {
+        VULKANKRAFT_PROFILE_ZONE("Chunk::generate job");
+        if (m_needs_face_update) {
+          update_faces();
+          m_needs_face_update = false;
+        }
 
-    m_vertices_ready = true;
-  });
+        m_mesh.generate_vertices(block_server, this, sections);
 
-  m_generating = true;
+        m_vertices_ready = true;
+      },
+      priority);
+  return m_generate_job;
 }
 
-void Chunk::generate_block_change(const block::Server &block_server,
-                                  const glm::ivec3 &position) {
-  compute_sun_light();
+void Chunk::apply_block_change(const glm::ivec3 &position) {
   _check_neighboring_faces_of_block(position);
+  // Marks the sections whose light has changed in every affected chunk
+  LightEngine().update(*this, position);
+
+  // The faces of the blocks above and below can change
+  const int lowest_y{std::max(position.y - 1, 0)};
+  const int highest_y{std::min(position.y + 1, block_height - 1)};
+
+  SectionMask sections;
+  for (int s = lowest_y / section_height; s <= highest_y / section_height;
+       s++) {
+    sections.set(s);
+  }
 
   if (auto left(m_left.lock()); position.x == 0 && left) {
     left->_check_faces_of_block(
         glm::ivec3(block_width - 1, position.y, position.z));
-    left->generate(block_server, false);
+    left->m_changed_sections |= sections;
   }
   if (auto right(m_right.lock()); position.x == block_width - 1 && right) {
     right->_check_faces_of_block(glm::ivec3(0, position.y, position.z));
-    right->generate(block_server, false);
+    right->m_changed_sections |= sections;
   }
   if (auto front(m_front.lock()); position.z == 0 && front) {
     front->_check_faces_of_block(
         glm::ivec3(position.x, position.y, block_depth - 1));
-    front->generate(block_server, false);
+    front->m_changed_sections |= sections;
   }
   if (auto back(m_back.lock()); position.z == block_depth - 1 && back) {
     back->_check_faces_of_block(glm::ivec3(position.x, position.y, 0));
-    back->generate(block_server, false);
+    back->m_changed_sections |= sections;
   }
 
-  generate(block_server, false);
+  m_changed_sections |= sections;
+}
+
+bool Chunk::generate_changes(const block::Server &block_server) {
+  // Waiting for the running job would block the frame. The changes are kept
+  // and get combined with the changes of the next frames instead
+  if (!m_generate_job.is_done()) {
+    return false;
+  }
+
+  const auto sections{m_changed_sections |
+                       SectionMask(m_relit_sections.exchange(0))};
+  m_changed_sections.reset();
+  generate(block_server, true, sections, ::core::JobSystem::Priority::HIGH);
+  return true;
 }
 
 physics::AABB Chunk::to_aabb() const {
@@ -84,120 +130,185 @@ physics::AABB Chunk::to_aabb() const {
 }
 
 void Chunk::update_faces() {
-  for (size_t x = 0; x < block_width; x++) {
-    for (size_t y = 0; y < block_height; y++) {
-      for (size_t z = 0; z < block_depth; z++) {
-        _check_faces(this, x, y, z, get_block(x, y, z));
-      }
+  // The border columns of the neighbours are only read once. A missing
+  // neighbour counts as air so that the faces on the border are visible
+  std::array<ColumnMask, block_depth> left_border, right_border;
+  std::array<ColumnMask, block_width> front_border, back_border;
+  {
+    const auto left(m_left.lock()), right(m_right.lock());
+    const auto front(m_front.lock()), back(m_back.lock());
+    for (size_t z = 0; z < block_depth; z++) {
+      left_border[z] =
+          left ? left->get_column(block_width - 1, z) : ColumnMask();
+      right_border[z] = right ? right->get_column(0, z) : ColumnMask();
+    }
+    for (size_t x = 0; x < block_width; x++) {
+      front_border[x] =
+          front ? front->get_column(x, block_depth - 1) : ColumnMask();
+      back_border[x] = back ? back->get_column(x, 0) : ColumnMask();
     }
   }
-}
 
-void Chunk::render(const ::core::vulkan::RenderCall &render_call,
-                   size_t &max_chunk_gen) {
-  check_mesh(max_chunk_gen);
+  for (size_t x = 0; x < block_width; x++) {
+    for (size_t z = 0; z < block_depth; z++) {
+      const auto &column{get_column(x, z)};
+      // The faces of air blocks are never used
+      if (column.empty()) {
+        continue;
+      }
 
-  m_mesh.render(render_call);
+      const auto &left{x == 0 ? left_border[z] : get_column(x - 1, z)};
+      const auto &right{x == block_width - 1 ? right_border[z]
+                                             : get_column(x + 1, z)};
+      const auto &front{z == block_depth - 1 ? back_border[x]
+                                             : get_column(x, z + 1)};
+      const auto &back{z == 0 ? front_border[x] : get_column(x, z - 1)};
+
+      // A face is visible if the block is solid and its neighbour is not.
+      // Shifting the column in and out of the world leaves air at the top and
+      // bottom of the world
+      const auto left_faces{column.and_not(left)};
+      const auto right_faces{column.and_not(right)};
+      const auto front_faces{column.and_not(front)};
+      const auto back_faces{column.and_not(back)};
+      const auto top_faces{column.and_not(column.shift_down())};
+      const auto bot_faces{column.and_not(column.shift_up())};
+
+      column.for_each([&](const size_t y) {
+        get_block(x, y, z).set_faces(
+            front_faces.test(y), back_faces.test(y), left_faces.test(y),
+            right_faces.test(y), top_faces.test(y), bot_faces.test(y));
+      });
+    }
+  }
 }
 
-int Chunk::get_height(glm::ivec3 world_pos) const {
-  world_pos.x -= m_position.x;
-  world_pos.z -= m_position.y;
-
-  int height{0};
-  block::Type block_type;
+bool Chunk::is_section_sealed(const size_t section) const {
+  // The top and bottom of the world are always visible
+  if (section == 0 || section == section_count - 1) {
+    return false;
+  }
 
-  for (int y = 0; y < block_height; y++) {
-    block_type = get(world_pos.x, y, world_pos.z);
-    height = (block_type != block::Type::AIR) * (y + 1) +
-             (block_type == block::Type::AIR) * height;
+  if (!get_section(section).is_full() ||
+      !get_section(section - 1).is_full() ||
+      !get_section(section + 1).is_full()) {
+    return false;
   }
 
-  return height;
+  const auto left(m_left.lock());
+  const auto right(m_right.lock());
+  const auto front(m_front.lock());
+  const auto back(m_back.lock());
+
+  return left && left->get_section(section).is_full() && right &&
+         right->get_section(section).is_full() && front &&
+         front->get_section(section).is_full() && back &&
+         back->get_section(section).is_full();
 }
 
-void Chunk::compute_sun_light() {
-  // NOTE: The light shouldn't be set everytime the block is at a border. But
-  // this has been done since it avoids artifacts that would look worse
-  for (int x = 0; x < block_width; x++) {
-    for (int z = 0; z < block_depth; z++) {
-      float light_value{1.0f};
+void Chunk::cull_sections(const physics::Frustum &frustum) {
+  m_visible_sections.reset();
+  m_frustum_sections.reset();
+
+  // Many chunks lie completely outside of the frustum, so the sections are
+  // only tested if the chunk intersects it
+  if (frustum.intersects(to_aabb())) {
+    std::array<physics::AABB, section_count> section_aabbs;
+    for (size_t i = 0; i < section_count; i++) {
+      section_aabbs[i] = physics::AABB(
+          static_cast<float>(m_position.x),
+          static_cast<float>(i * section_height),
+          static_cast<float>(m_position.y), static_cast<float>(block_width),
+          static_cast<float>(section_height), static_cast<float>(block_depth));
+    }
 
-      for (int y = block_height - 1; y >= 0; y--) {
-        auto &block = get_block(x, y, z);
-        if (block.type != block::Type::AIR) {
-          block.set_top_light(light_value);
-          light_value = 1.0f / static_cast<float>(0b1111);
-        }
+    std::array<uint8_t, section_count> visible;
+    frustum.intersects(section_aabbs.data(), section_count, visible.data());
+    for (size_t i = 0; i < section_count; i++) {
+      m_frustum_sections[i] = visible[i] != 0;
+    }
+  }
+}
 
-        if (x != 0) {
-          get_block(x - 1, y, z).set_right_light(light_value);
-        } else {
-          if (auto left(m_left.lock()); left) {
-            left->get_block(block_width - 1, y, z).set_right_light(light_value);
-          }
-          block.set_left_light(1.0f);
-        }
+void Chunk::render(MeshRenderer &renderer, size_t &max_chunk_gen) {
+  if (!m_mesh_buffer) {
+    return;
+  }
 
-        if (x != block_width - 1) {
-          get_block(x + 1, y, z).set_left_light(light_value);
-        } else {
-          if (auto right(m_right.lock()); right) {
-            right->get_block(0, y, z).set_left_light(light_value);
-          }
-          block.set_right_light(1.0f);
-        }
+  check_mesh(max_chunk_gen);
 
-        if (z != 0) {
-          get_block(x, y, z - 1).set_front_light(light_value);
-        } else {
-          if (auto front(m_front.lock()); front) {
-            front->get_block(x, y, block_depth - 1)
-                .set_front_light(light_value);
-          }
-          block.set_back_light(1.0f);
-        }
+  m_mesh_buffer->add_draws(renderer, m_position, m_frustum_sections,
+                           m_visible_sections & m_frustum_sections);
+}
 
-        if (z != block_depth - 1) {
-          get_block(x, y, z + 1).set_back_light(light_value);
-        } else {
-          if (auto back(m_back.lock()); back) {
-            back->get_block(x, y, 0).set_back_light(light_value);
-          }
-          block.set_front_light(1.0f);
-        }
-      }
-    }
-  }
+int Chunk::get_height(glm::ivec3 world_pos) const {
+  return static_cast<int>(get_column_height(world_pos.x - m_position.x,
+                                            world_pos.z - m_position.y));
 }
 
+void Chunk::compute_light() { LightEngine().compute(*this); }
+
 void Chunk::from_world_generation(
     const world_gen::WorldGeneration &world_generation) {
   world_generation.generate(m_position, *this);
 }
 
-void Chunk::_check_faces(const Chunk *chunk, const size_t x, const size_t y,
-                         const size_t z, Block &block) {
-  block.left_face(x == 0 || !chunk->get(x - 1, y, z));
-  block.right_face(x == block_width - 1 || !chunk->get(x + 1, y, z));
+int Chunk::_get_neighbourhood_height(const int x, const int z) const {
+  auto height{get_column_height(x, z)};
 
-  block.front_face(z == block_depth - 1 || !chunk->get(x, y, z + 1));
-  block.back_face(z == 0 || !chunk->get(x, y, z - 1));
+  if (x != 0) {
+    height = std::max(height, get_column_height(x - 1, z));
+  } else if (auto left(m_left.lock()); left) {
+    height = std::max(height, left->get_column_height(block_width - 1, z));
+  }
+  if (x != block_width - 1) {
+    height = std::max(height, get_column_height(x + 1, z));
+  } else if (auto right(m_right.lock()); right) {
+    height = std::max(height, right->get_column_height(0, z));
+  }
+  if (z != 0) {
+    height = std::max(height, get_column_height(x, z - 1));
+  } else if (auto front(m_front.lock()); front) {
+    height = std::max(height, front->get_column_height(x, block_depth - 1));
+  }
+  if (z != block_depth - 1) {
+    height = std::max(height, get_column_height(x, z + 1));
+  } else if (auto back(m_back.lock()); back) {
+    height = std::max(height, back->get_column_height(x, 0));
+  }
 
-  block.top_face(y == block_height - 1 || !chunk->get(x, y + 1, z));
-  block.bot_face(y == 0 || !chunk->get(x, y - 1, z));
+  return static_cast<int>(height);
+}
 
-  if (auto left(chunk->m_left.lock()); x == 0) {
-    block.left_face(!left || !left->get(block_width - 1, y, z));
+void Chunk::_check_faces(const Chunk *chunk, const size_t x, const size_t y,
+                         const size_t z, Block &block) {
+  const auto &column{chunk->get_column(x, z)};
+  block.top_face(y == block_height - 1 || !column.test(y + 1));
+  block.bot_face(y == 0 || !column.test(y - 1));
+
+  if (x == 0) {
+    const auto left(chunk->m_left.lock());
+    block.left_face(!left || !left->get_column(block_width - 1, z).test(y));
+  } else {
+    block.left_face(!chunk->get_column(x - 1, z).test(y));
   }
-  if (auto front(chunk->m_front.lock()); z == 0) {
-    block.back_face(!front || !front->get(x, y, block_depth - 1));
+  if (x == block_width - 1) {
+    const auto right(chunk->m_right.lock());
+    block.right_face(!right || !right->get_column(0, z).test(y));
+  } else {
+    block.right_face(!chunk->get_column(x + 1, z).test(y));
   }
-  if (auto right(chunk->m_right.lock()); x == block_width - 1) {
-    block.right_face(!right || !right->get(0, y, z));
+  if (z == 0) {
+    const auto front(chunk->m_front.lock());
+    block.back_face(!front || !front->get_column(x, block_depth - 1).test(y));
+  } else {
+    block.back_face(!chunk->get_column(x, z - 1).test(y));
   }
-  if (auto back(chunk->m_back.lock()); z == block_depth - 1) {
-    block.front_face(!back || !back->get(x, y, 0));
+  if (z == block_depth - 1) {
+    const auto back(chunk->m_back.lock());
+    block.front_face(!back || !back->get_column(x, 0).test(y));
+  } else {
+    block.front_face(!chunk->get_column(x, z + 1).test(y));
   }
 }
 
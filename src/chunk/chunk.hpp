@@ -1,36 +1,113 @@
 #pragma once
+#include "../core/job_system.hpp"
 #include "../physics/aabb.hpp"
+#include "../physics/frustum.hpp"
 #include "../world_gen/world_generation.hpp"
+#include "light.hpp"
 #include "mesh.hpp"
+#include "mesh_buffer.hpp"
 #include <array>
 #include <atomic>
 #include <memory>
-#include <thread>
 
 namespace chunk {
 class Chunk : public BlockArray {
 public:
   friend class Mesh;
+  friend class LightEngine;
 
-  Chunk(const ::core::vulkan::Context &context, const glm::ivec2 &position);
+  // The meshes are generated on the workers of job_system and uploaded into
+  // mesh_arena
+  Chunk(::core::vulkan::BufferArena &mesh_arena,
+        ::core::JobSystem &job_system, const glm::ivec2 &position,
+        const Mesh::Mode mesh_mode = Mesh::Mode::CULLED);
+  // Creates a chunk without GPU buffers. The generated vertices stay in the
+  // mesh and can be read with get_mesh
+  Chunk(::core::JobSystem &job_system, const glm::ivec2 &position,
+        const Mesh::Mode mesh_mode = Mesh::Mode::CULLED);
   ~Chunk();
 
-  void generate(const block::Server &block_server,
-                const bool multi_thread = true);
-  void generate_block_change(const block::Server &block_server,
-                             const glm::ivec3 &position);
+  // Generates the mesh of the given sections. If multi_thread is true the
+  // vertices are generated by a job with the given priority and get uploaded
+  // by the next call of check_mesh after the job has finished. Returns the job
+  ::core::JobSystem::Handle generate(const block::Server &block_server,
+                const bool multi_thread = true,
+                const SectionMask &sections = SectionMask().set(),
+                const ::core::JobSystem::Priority priority =
+                    ::core::JobSystem::Priority::NORMAL);
+  // Updates the faces and light after the block at position has been changed
+  // and marks the sections of this chunk and its neighbours which are affected
+  // by the change. They are regenerated by the next call of generate_changes.
+  // The light can change in every chunk which lies at most one chunk away
+  void apply_block_change(const glm::ivec3 &position);
+  // Regenerates all sections changed by apply_block_change with a high
+  // priority job. Returns false without doing anything if the previous job is
+  // still running
+  bool generate_changes(const block::Server &block_server);
+  // Returns wether sections have been changed or relit since the last call of
+  // generate_changes
+  inline bool has_changes() const {
+    return m_changed_sections.any() || m_relit_sections != 0;
+  }
+  // Forgets all changes. Used before the whole mesh is generated
+  inline void discard_changes() {
+    m_changed_sections.reset();
+    m_relit_sections = 0;
+  }
+  // Returns the job generating the mesh. It is only replaced by generate
+  inline ::core::JobSystem::Handle get_generation_job() const {
+    return m_generate_job;
+  }
   physics::AABB to_aabb() const;
   void update_faces();
-  void render(const ::core::vulkan::RenderCall &render_call,
-              size_t &max_chunk_gen);
+  // Tests which sections are inside of frustum and marks all sections as not
+  // visible. Needs to be called every frame before the visible sections are
+  // marked
+  void cull_sections(const physics::Frustum &frustum);
+  // Marks a section as visible. It gets drawn by the next call of render if it
+  // is inside of the frustum
+  inline void set_section_visible(const size_t section) {
+    m_visible_sections.set(section);
+  }
+  // Marks all sections inside of the frustum as visible
+  inline void set_frustum_sections_visible() {
+    m_visible_sections = m_frustum_sections;
+  }
+  inline bool is_section_visible(const size_t section) const {
+    return m_visible_sections[section];
+  }
+  inline bool is_section_in_frustum(const size_t section) const {
+    return m_frustum_sections[section];
+  }
+  // Returns which faces of the rendered mesh of the section are connected
+  inline const SectionVisibility &
+  get_section_visibility(const size_t section) const {
+    return m_mesh_buffer ? m_mesh_buffer->get_visibility(section)
+                         : m_mesh.get_visibility(section);
+  }
+  // Uploads the generated vertices if there is budget left in max_chunk_gen
+  // and adds the draws of the visible sections to renderer
+  void render(MeshRenderer &renderer, size_t &max_chunk_gen);
+  // Returns the height of the highest block of the column at world_pos plus
+  // one. Reads the heightmap so it does not scan the column
   int get_height(glm::ivec3 world_pos) const;
-  void compute_sun_light();
+  // Computes the sky light and block light of the whole chunk and lights the
+  // visible faces. The faces need to be up to date. The light also spreads
+  // into the neighbouring chunks, so no other chunk which lies at most two
+  // chunks away may compute its light at the same time. The sections of the
+  // other chunks whose faces are lit get marked as relit
+  void compute_light();
+  // Returns wether the section and all its neighbouring sections are full. A
+  // sealed section has no visible faces
+  bool is_section_sealed(const size_t section) const;
 
   inline void set_front(std::shared_ptr<Chunk> c) { m_front = c; }
   inline void set_back(std::shared_ptr<Chunk> c) { m_back = c; }
   inline void set_left(std::shared_ptr<Chunk> c) { m_left = c; }
   inline void set_right(std::shared_ptr<Chunk> c) { m_right = c; }
   inline void needs_face_update() { m_needs_face_update = true; }
+  // Sets how the mesh will be generated the next time generate is called
+  inline void set_mesh_mode(const Mesh::Mode mode) { m_mesh.set_mode(mode); }
 
   inline std::shared_ptr<Chunk> get_front() { return m_front.lock(); }
   inline std::shared_ptr<Chunk> get_back() { return m_back.lock(); }
@@ -45,14 +122,19 @@ public:
     return m_right.lock();
   }
   inline const glm::ivec2 &get_position() const { return m_position; }
+  inline const Mesh &get_mesh() const { return m_mesh; }
+  // Returns the amount of bytes used to store the blocks and the light
+  inline size_t memory_usage() const {
+    return BlockArray::memory_usage() + m_light.memory_usage();
+  }
 
   inline bool check_mesh(size_t &max_chunk_gen) {
-    if (max_chunk_gen == 0) {
+    if (max_chunk_gen == 0 || !m_mesh_buffer) {
       return false;
     }
 
     if (m_vertices_ready) {
-      m_mesh.load_buffer();
+      m_mesh_buffer->load(m_mesh);
       m_vertices_ready = false;
       max_chunk_gen--;
       return true;
@@ -64,21 +146,45 @@ public:
   from_world_generation(const world_gen::WorldGeneration &world_generation);
 
 private:
+  // Returns the highest column height of the column at x and z and its four
+  // neighbouring columns which can lie in the neighbouring chunks
+  int _get_neighbourhood_height(const int x, const int z) const;
+
   static void _check_faces(const Chunk *chunk, const size_t x, const size_t y,
                            const size_t z, Block &block);
 
   void _check_faces_of_block(const glm::ivec3 &position);
+  // Marks a section whose faces have been lit by the light computation of
+  // another chunk. It can be called without the chunk being locked
+  inline void _mark_relit(const size_t section) {
+    m_relit_sections.fetch_or(static_cast<uint8_t>(1 << section),
+                              std::memory_order_relaxed);
+  }
   void _check_neighboring_faces_of_block(const glm::ivec3 &position);
 
+  LightVolume m_light;
   Mesh m_mesh;
+  // The uploaded vertices. It is null if the chunk has been created without
+  // GPU buffers
+  std::unique_ptr<MeshBuffer> m_mesh_buffer;
   const glm::ivec2 m_position;
   std::atomic<bool> m_needs_face_update;
-  std::unique_ptr<std::thread> m_generate_thread;
+  ::core::JobSystem &m_job_system;
+  // The job which generates the vertices of the mesh
+  ::core::JobSystem::Handle m_generate_job;
   // Wether there are currently newly generated vertices that need to be
   // uploaded to the GPU
   std::atomic<bool> m_vertices_ready;
-  // Wether the generate thread has been started, but has not been joined yet
-  std::atomic<bool> m_generating;
+  // The sections which have been changed by apply_block_change, but have not
+  // been regenerated yet
+  SectionMask m_changed_sections;
+  // The sections lit by compute_light of other chunks. They are regenerated
+  // together with the changed sections
+  std::atomic<uint8_t> m_relit_sections;
+  // The sections inside of the frustum of the current frame
+  SectionMask m_frustum_sections;
+  // The sections which can be seen from the camera in the current frame
+  SectionMask m_visible_sections;
 
   std::weak_ptr<Chunk> m_front;
   std::weak_ptr<Chunk> m_back;
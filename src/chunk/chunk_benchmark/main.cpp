@@ -0,0 +1,335 @@
+#include "../../block/server.hpp"
+#include "../../core/exception.hpp"
+#include "../../core/job_system.hpp"
+#include "../../core/log.hpp"
+#include "../../save/world.hpp"
+#include "../../world_gen/perlin_noise.hpp"
+#include "../../world_gen/world_generation.hpp"
+#include "../chunk.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Runs every stage of the chunk pipeline over a grid of chunks without a
+// Vulkan device and writes the measurements into a JSON file. It also
+// compares sampling the 3D noise of the terrain at every block with
+// interpolating it
+//
+// Usage: chunk_benchmark [--grid <size>] [--seed <seed>]
+//                        [--mode <culled|greedy>] [--output <file>]
+
+struct Options {
+  // The amount of chunks along both axes of the grid
+  int grid_size{16};
+  size_t seed{0};
+  chunk::Mesh::Mode mesh_mode{chunk::Mesh::Mode::CULLED};
+  std::filesystem::path output{"chunk_benchmark.json"};
+};
+
+// The measurements of one stage of the pipeline
+struct Stage {
+  std::string name;
+  // The time each chunk took in nanoseconds
+  std::vector<int64_t> times;
+  // The amount of vertices generated by the stage
+  size_t vertex_count{0};
+};
+
+using ChunkGrid = std::vector<std::shared_ptr<chunk::Chunk>>;
+
+static Options parse_options(const int args, char *argv[]) {
+  Options options;
+
+  for (int i = 1; i < args; i++) {
+    const std::string option(argv[i]);
+    if (i + 1 == args) {
+      throw core::VulkanKraftException("missing value of option " + option);
+    }
+    const std::string value(argv[++i]);
+
+    try {
+      if (option == "--grid") {
+        options.grid_size = std::stoi(value);
+      } else if (option == "--seed") {
+        options.seed = std::stoull(value);
+      } else if (option == "--mode") {
+        if (value == "culled") {
+          options.mesh_mode = chunk::Mesh::Mode::CULLED;
+        } else if (value == "greedy") {
+          options.mesh_mode = chunk::Mesh::Mode::GREEDY;
+        } else {
+          throw std::invalid_argument(value);
+        }
+      } else if (option == "--output") {
+        options.output = value;
+      } else {
+        throw core::VulkanKraftException("unknown option " + option);
+      }
+    } catch (const std::logic_error &) {
+      throw core::VulkanKraftException("invalid value \"" + value +
+                                       "\" of option " + option);
+    }
+  }
+
+  if (options.grid_size <= 0) {
+    throw core::VulkanKraftException("the grid size needs to be positive");
+  }
+
+  return options;
+}
+
+// Creates the chunks of the grid centered around the origin and connects them
+// with their neighbours
+static ChunkGrid create_grid(core::JobSystem &job_system,
+                             const Options &options) {
+  const auto size{options.grid_size};
+  const auto offset{-size / 2};
+
+  ChunkGrid chunks;
+  chunks.reserve(size * size);
+  for (int z = 0; z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      chunks.push_back(std::make_shared<chunk::Chunk>(
+          job_system,
+          glm::ivec2((x + offset) * chunk::block_width,
+                     (z + offset) * chunk::block_depth),
+          options.mesh_mode));
+    }
+  }
+
+  for (int z = 0; z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      auto &c{chunks[x + z * size]};
+      if (x != 0) {
+        c->set_left(chunks[x - 1 + z * size]);
+      }
+      if (x != size - 1) {
+        c->set_right(chunks[x + 1 + z * size]);
+      }
+      if (z != 0) {
+        c->set_front(chunks[x + (z - 1) * size]);
+      }
+      if (z != size - 1) {
+        c->set_back(chunks[x + (z + 1) * size]);
+      }
+    }
+  }
+
+  return chunks;
+}
+
+// Runs the stage for every chunk and measures each call. run returns the
+// amount of vertices it has generated
+template <typename Run>
+static Stage measure(const std::string &name, ChunkGrid &chunks, Run run) {
+  Stage stage;
+  stage.name = name;
+  stage.times.reserve(chunks.size());
+
+  for (auto &c : chunks) {
+    const auto start{std::chrono::steady_clock::now()};
+    stage.vertex_count += run(*c);
+    const auto end{std::chrono::steady_clock::now()};
+
+    stage.times.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+            .count());
+  }
+
+  return stage;
+}
+
+// Measures the 3D noise of the density of the terrain at every block of the
+// chunks once sampled at every block and once interpolated from the coarse
+// lattice the world generation uses. Returns the largest difference between
+// both
+static float measure_density_noise(const Options &options, ChunkGrid &chunks,
+                                   std::vector<Stage> &stages) {
+  // The parameters of the density of the world generation
+  constexpr float frequency = 0.03f;
+  constexpr int octaves = 4;
+  const glm::ivec3 cell_size(4, 8, 4);
+  const glm::ivec3 size(chunk::block_width, chunk::block_height,
+                        chunk::block_depth);
+
+  world_gen::PerlinNoise noise;
+  noise.seed(options.seed);
+  std::vector<float> sampled(size.x * size.y * size.z);
+  std::vector<float> interpolated(sampled.size());
+
+  stages.push_back(measure("density_sampled", chunks, [&](chunk::Chunk &c) {
+    const auto &position{c.get_position()};
+    for (int y = 0; y < size.y; y++) {
+      for (int z = 0; z < size.z; z++) {
+        for (int x = 0; x < size.x; x++) {
+          sampled[x + (z + y * size.z) * size.x] = noise.get_3d(
+              static_cast<float>(position.x + x), static_cast<float>(y),
+              static_cast<float>(position.y + z), frequency, octaves);
+        }
+      }
+    }
+    return size_t(0);
+  }));
+  stages.push_back(
+      measure("density_interpolated", chunks, [&](chunk::Chunk &c) {
+        const auto &position{c.get_position()};
+        noise.get_interpolated_grid(glm::ivec3(position.x, 0, position.y),
+                                    size, cell_size, interpolated.data(),
+                                    frequency, octaves);
+        return size_t(0);
+      }));
+
+  // Only the last chunk is compared since both buffers are overwritten
+  float max_difference{0.0f};
+  for (size_t i = 0; i < sampled.size(); i++) {
+    max_difference =
+        std::max(max_difference, std::abs(sampled[i] - interpolated[i]));
+  }
+  return max_difference;
+}
+
+// Returns the value below which the fraction p of the sorted times lie
+static int64_t percentile(const std::vector<int64_t> &sorted_times,
+                          const double p) {
+  const auto rank{static_cast<size_t>(p * sorted_times.size())};
+  return sorted_times[std::min(rank, sorted_times.size() - 1)];
+}
+
+static json report(const Stage &stage) {
+  auto times(stage.times);
+  std::sort(times.begin(), times.end());
+
+  constexpr auto blocks_per_chunk{chunk::block_width * chunk::block_depth *
+                                  chunk::block_height};
+  const auto total{std::accumulate(times.begin(), times.end(), int64_t(0))};
+  const auto seconds{std::max(static_cast<double>(total) * 1e-9, 1e-9)};
+
+  json result;
+  result["name"] = stage.name;
+  result["chunks"] = times.size();
+  result["vertices"] = stage.vertex_count;
+  result["total_ms"] = static_cast<double>(total) * 1e-6;
+  result["chunks_per_second"] = static_cast<double>(times.size()) / seconds;
+  result["vertices_per_second"] =
+      static_cast<double>(stage.vertex_count) / seconds;
+  result["ns_per_block"] = static_cast<double>(total) /
+                           static_cast<double>(times.size() * blocks_per_chunk);
+  result["p50_us"] = static_cast<double>(percentile(times, 0.5)) * 1e-3;
+  result["p99_us"] = static_cast<double>(percentile(times, 0.99)) * 1e-3;
+
+  std::stringstream stream;
+  stream << stage.name << ": "
+         << result["chunks_per_second"].get<double>() << " chunks/s, "
+         << result["vertices_per_second"].get<double>() << " vertices/s, "
+         << result["ns_per_block"].get<double>() << " ns/block, p50 "
+         << result["p50_us"].get<double>() << " us, p99 "
+         << result["p99_us"].get<double>() << " us";
+  core::Log::info(stream.str());
+
+  return result;
+}
+
+int main(int args, char *argv[]) {
+  try {
+    const auto options(parse_options(args, argv));
+
+    // Every stage runs on the main thread so that the chunks are measured
+    // one after another
+    core::JobSystem job_system(1);
+    block::Server block_server;
+    world_gen::WorldGeneration world_generation(options.seed);
+
+    const auto save_folder(std::filesystem::temp_directory_path() /
+                           "vulkankraft_chunk_benchmark");
+    std::filesystem::remove_all(save_folder);
+    save::World save_world(save_folder);
+
+    auto chunks(create_grid(job_system, options));
+    core::Log::info("running the chunk pipeline over " +
+                    std::to_string(chunks.size()) + " chunks");
+
+    // The stages run in the same order as when the world loads chunks. Every
+    // stage needs the results of the previous stages of all neighbours. The
+    // light is computed after the faces since only visible faces are lit
+    std::vector<Stage> stages;
+    stages.push_back(
+        measure("world_generation", chunks, [&](chunk::Chunk &c) {
+          c.from_world_generation(world_generation);
+          return size_t(0);
+        }));
+    stages.push_back(measure("face_culling", chunks, [](chunk::Chunk &c) {
+      c.update_faces();
+      return size_t(0);
+    }));
+    stages.push_back(measure("light", chunks, [](chunk::Chunk &c) {
+      c.compute_light();
+      return size_t(0);
+    }));
+    stages.push_back(measure("meshing", chunks, [&](chunk::Chunk &c) {
+      c.generate(block_server, false);
+
+      size_t vertex_count{0};
+      for (size_t s = 0; s < chunk::section_count; s++) {
+        vertex_count += c.get_mesh().get_vertices(s).size();
+      }
+      return vertex_count;
+    }));
+    stages.push_back(measure("serialisation", chunks, [&](chunk::Chunk &c) {
+      const auto &position{c.get_position()};
+      save_world.store_chunk(std::make_pair(position.x / chunk::block_width,
+                                            position.y / chunk::block_depth),
+                             c.to_stored_blocks());
+      return size_t(0);
+    }));
+
+    std::filesystem::remove_all(save_folder);
+
+    const auto density_difference{
+        measure_density_noise(options, chunks, stages)};
+    core::Log::info("largest difference of the interpolated density: " +
+                    std::to_string(density_difference));
+
+    json result;
+    result["grid_size"] = options.grid_size;
+    result["seed"] = options.seed;
+    result["mesh_mode"] =
+        options.mesh_mode == chunk::Mesh::Mode::GREEDY ? "greedy" : "culled";
+    result["stages"] = json::array();
+    for (const auto &stage : stages) {
+      result["stages"].push_back(report(stage));
+    }
+    result["density_max_difference"] = density_difference;
+
+    const auto noise_cache(world_generation.get_noise_cache_statistics());
+    result["noise_cache"]["hits"] = noise_cache.hits;
+    result["noise_cache"]["misses"] = noise_cache.misses;
+    result["noise_cache"]["hit_rate"] = noise_cache.get_hit_rate();
+    core::Log::info("noise cache: " + std::to_string(noise_cache.hits) +
+                    " hits, " + std::to_string(noise_cache.misses) +
+                    " misses");
+
+    std::ofstream file(options.output);
+    if (file.fail()) {
+      throw core::VulkanKraftException("failed to open " +
+                                       options.output.string());
+    }
+    file << result.dump(2) << std::endl;
+    core::Log::info("wrote results to " + options.output.string());
+  } catch (const core::VulkanKraftException &e) {
+    core::Log::error(e.what());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "chunk_map.hpp"
+
+namespace chunk {
+ChunkMap::ChunkMap() { _rehash(initial_slot_count); }
+
+bool ChunkMap::emplace(const Position &pos, std::shared_ptr<Chunk> chunk) {
+  const auto key{_key(pos)};
+  if (_find_slot(key) != npos) {
+    return false;
+  }
+
+  // Keep the load factor at or below one half so that the probe sequences
+  // stay short
+  if ((m_entries.size() + 1) * 2 > m_slots.size()) {
+    _rehash(m_slots.size() * 2);
+  }
+
+  auto slot{_home_slot(key)};
+  while (m_slots[slot].index != empty_slot) {
+    slot = (slot + 1) & m_slot_mask;
+  }
+
+  m_slots[slot] = Slot{key, static_cast<uint32_t>(m_entries.size())};
+  m_entries.emplace_back(pos, std::move(chunk));
+  return true;
+}
+
+bool ChunkMap::erase(const Position &pos) {
+  auto slot{_find_slot(_key(pos))};
+  if (slot == npos) {
+    return false;
+  }
+
+  // Move the last entry into the gap and point its slot to the new index
+  const auto index{m_slots[slot].index};
+  if (index != m_entries.size() - 1) {
+    m_entries[index] = std::move(m_entries.back());
+    m_slots[_find_slot(_key(m_entries[index].first))].index = index;
+  }
+  m_entries.pop_back();
+
+  // Shift the following slots of the probe sequence back so that no
+  // tombstones are needed
+  for (auto next{(slot + 1) & m_slot_mask};
+       m_slots[next].index != empty_slot; next = (next + 1) & m_slot_mask) {
+    const auto home{_home_slot(m_slots[next].key)};
+    // The slot can only be moved back if its home slot does not lie cyclically
+    // between the gap and itself
+    const auto distance_to_next{(next - home) & m_slot_mask};
+    const auto distance_to_gap{(slot - home) & m_slot_mask};
+    if (distance_to_gap < distance_to_next) {
+      m_slots[slot] = m_slots[next];
+      slot = next;
+    }
+  }
+  m_slots[slot].index = empty_slot;
+
+  return true;
+}
+
+void ChunkMap::clear() {
+  m_entries.clear();
+  _rehash(initial_slot_count);
+}
+
+void ChunkMap::_rehash(const size_t slot_count) {
+  m_slots.assign(slot_count, Slot{0, empty_slot});
+  m_slot_mask = slot_count - 1;
+  m_slot_shift = 64;
+  for (auto count{slot_count}; count > 1; count >>= 1) {
+    m_slot_shift--;
+  }
+
+  for (size_t i = 0; i < m_entries.size(); i++) {
+    const auto key{_key(m_entries[i].first)};
+    auto slot{_home_slot(key)};
+    while (m_slots[slot].index != empty_slot) {
+      slot = (slot + 1) & m_slot_mask;
+    }
+    m_slots[slot] = Slot{key, static_cast<uint32_t>(i)};
+  }
+}
+} // namespace chunk
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace chunk {
+class Chunk;
+
+// Maps chunk positions to chunks. The chunks are stored densely in a vector
+// so that iterating over them does not chase pointers. They are found with an
+// open addressing hash table using linear probing which stores the packed
+// chunk positions next to the indices into the vector
+class ChunkMap {
+public:
+  using Position = std::pair<int, int>;
+  using Entry = std::pair<Position, std::shared_ptr<Chunk>>;
+  using iterator = std::vector<Entry>::iterator;
+  using const_iterator = std::vector<Entry>::const_iterator;
+
+  ChunkMap();
+
+  // Returns the chunk at pos or nullptr if there is none
+  inline std::shared_ptr<Chunk> *find(const Position &pos) {
+    const auto slot{_find_slot(_key(pos))};
+    return slot == npos ? nullptr : &m_entries[m_slots[slot].index].second;
+  }
+  inline const std::shared_ptr<Chunk> *find(const Position &pos) const {
+    const auto slot{_find_slot(_key(pos))};
+    return slot == npos ? nullptr : &m_entries[m_slots[slot].index].second;
+  }
+  inline bool contains(const Position &pos) const {
+    return _find_slot(_key(pos)) != npos;
+  }
+
+  // Adds chunk at pos. Returns false and does nothing if there already is a
+  // chunk at pos
+  bool emplace(const Position &pos, std::shared_ptr<Chunk> chunk);
+  // Removes the chunk at pos. The last chunk of the vector takes its place.
+  // Returns false if there is no chunk at pos
+  bool erase(const Position &pos);
+  void clear();
+
+  inline size_t size() const { return m_entries.size(); }
+  inline bool empty() const { return m_entries.empty(); }
+
+  inline iterator begin() { return m_entries.begin(); }
+  inline iterator end() { return m_entries.end(); }
+  inline const_iterator begin() const { return m_entries.begin(); }
+  inline const_iterator end() const { return m_entries.end(); }
+
+private:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+  static constexpr uint32_t empty_slot = static_cast<uint32_t>(-1);
+  static constexpr size_t initial_slot_count = 256;
+
+  struct Slot {
+    uint64_t key;
+    // Index into m_entries or empty_slot
+    uint32_t index;
+  };
+
+  static inline uint64_t _key(const Position &pos) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(pos.first)) << 32) |
+           static_cast<uint32_t>(pos.second);
+  }
+
+  // Returns the slot at which the search for key starts
+  inline size_t _home_slot(const uint64_t key) const {
+    // Fibonacci hashing spreads neighbouring positions over the whole table
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> m_slot_shift);
+  }
+
+  inline size_t _find_slot(const uint64_t key) const {
+    for (auto slot{_home_slot(key)};; slot = (slot + 1) & m_slot_mask) {
+      const auto &s{m_slots[slot]};
+      if (s.index == empty_slot) {
+        return npos;
+      }
+      if (s.key == key) {
+        return slot;
+      }
+    }
+  }
+
+  // Creates a table with slot_count slots and inserts all entries into it
+  void _rehash(const size_t slot_count);
+
+  std::vector<Entry> m_entries;
+  std::vector<Slot> m_slots;
+  size_t m_slot_mask;
+  uint8_t m_slot_shift;
+};
+} // namespace chunk
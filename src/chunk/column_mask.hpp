@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VULKANKRAFT_COLUMN_MASK_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace chunk {
+// A bitmask of one column of 128 blocks. Bit y represents the block at height
+// y. The operations use SSE2 if it is available so that a whole column is
+// processed with one instruction
+class alignas(16) ColumnMask {
+public:
+  static constexpr size_t bit_count = 128;
+
+  constexpr ColumnMask() : m_words{0, 0} {}
+  constexpr ColumnMask(const uint64_t low, const uint64_t high)
+      : m_words{low, high} {}
+
+  static constexpr ColumnMask full() { return ColumnMask(~0ull, ~0ull); }
+
+  inline bool test(const size_t y) const {
+    return (m_words[y >> 6] >> (y & 63)) & 1;
+  }
+  inline void set(const size_t y, const bool value) {
+    const auto bit{1ull << (y & 63)};
+    m_words[y >> 6] = (m_words[y >> 6] & ~bit) | (bit * value);
+  }
+  inline bool empty() const { return (m_words[0] | m_words[1]) == 0; }
+  // Returns the index of the highest set bit plus one or 0 if no bit is set
+  inline size_t height() const {
+    if (m_words[1] != 0) {
+      return 128 - _count_leading_zeros(m_words[1]);
+    }
+    if (m_words[0] != 0) {
+      return 64 - _count_leading_zeros(m_words[0]);
+    }
+    return 0;
+  }
+
+  // Returns this & ~other
+  inline ColumnMask and_not(const ColumnMask &other) const {
+    ColumnMask result;
+#ifdef VULKANKRAFT_COLUMN_MASK_SSE2
+    _mm_store_si128(reinterpret_cast<__m128i *>(result.m_words),
+                    _mm_andnot_si128(_load(other), _load(*this)));
+#else
+    result.m_words[0] = m_words[0] & ~other.m_words[0];
+    result.m_words[1] = m_words[1] & ~other.m_words[1];
+#endif
+    return result;
+  }
+
+  // Moves every bit one block up. Bit y becomes bit y + 1
+  inline ColumnMask shift_up() const {
+    ColumnMask result;
+#ifdef VULKANKRAFT_COLUMN_MASK_SSE2
+    const auto value{_load(*this)};
+    _mm_store_si128(
+        reinterpret_cast<__m128i *>(result.m_words),
+        _mm_or_si128(_mm_slli_epi64(value, 1),
+                     _mm_srli_epi64(_mm_slli_si128(value, 8), 63)));
+#else
+    result.m_words[0] = m_words[0] << 1;
+    result.m_words[1] = (m_words[1] << 1) | (m_words[0] >> 63);
+#endif
+    return result;
+  }
+
+  // Moves every bit one block down. Bit y becomes bit y - 1
+  inline ColumnMask shift_down() const {
+    ColumnMask result;
+#ifdef VULKANKRAFT_COLUMN_MASK_SSE2
+    const auto value{_load(*this)};
+    _mm_store_si128(
+        reinterpret_cast<__m128i *>(result.m_words),
+        _mm_or_si128(_mm_srli_epi64(value, 1),
+                     _mm_slli_epi64(_mm_srli_si128(value, 8), 63)));
+#else
+    result.m_words[0] = (m_words[0] >> 1) | (m_words[1] << 63);
+    result.m_words[1] = m_words[1] >> 1;
+#endif
+    return result;
+  }
+
+  // Calls func with the height of every set bit in ascending order
+  template <typename F> inline void for_each(F &&func) const {
+    for (size_t i = 0; i < 2; i++) {
+      auto word{m_words[i]};
+      while (word != 0) {
+        func(i * 64 + _count_trailing_zeros(word));
+        word &= word - 1;
+      }
+    }
+  }
+
+  inline bool operator==(const ColumnMask &other) const {
+    return m_words[0] == other.m_words[0] && m_words[1] == other.m_words[1];
+  }
+
+private:
+#ifdef VULKANKRAFT_COLUMN_MASK_SSE2
+  static inline __m128i _load(const ColumnMask &mask) {
+    return _mm_load_si128(reinterpret_cast<const __m128i *>(mask.m_words));
+  }
+#endif
+
+  static inline size_t _count_trailing_zeros(const uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return index;
+#else
+    return __builtin_ctzll(word);
+#endif
+  }
+
+  static inline size_t _count_leading_zeros(const uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return 63 - index;
+#else
+    return __builtin_clzll(word);
+#endif
+  }
+
+  uint64_t m_words[2];
+};
+} // namespace chunk
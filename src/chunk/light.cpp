@@ -0,0 +1,413 @@
+#include "light.hpp"
+#include "chunk.hpp"
+
+namespace chunk {
+namespace {
+inline glm::ivec3 to_position(const size_t index) {
+  return glm::ivec3(index % block_width, index / (block_width * block_depth),
+                    (index / block_width) % block_depth);
+}
+
+inline Block::Face opposite(const Block::Face face) {
+  switch (face) {
+  case Block::FRONT:
+    return Block::BACK;
+  case Block::BACK:
+    return Block::FRONT;
+  case Block::LEFT:
+    return Block::RIGHT;
+  case Block::RIGHT:
+    return Block::LEFT;
+  case Block::TOP:
+    return Block::BOT;
+  default:
+    return Block::TOP;
+  }
+}
+
+inline void set_face_light(Block &block, const Block::Face face,
+                           const float light) {
+  switch (face) {
+  case Block::FRONT:
+    block.set_front_light(light);
+    break;
+  case Block::BACK:
+    block.set_back_light(light);
+    break;
+  case Block::LEFT:
+    block.set_left_light(light);
+    break;
+  case Block::RIGHT:
+    block.set_right_light(light);
+    break;
+  case Block::TOP:
+    block.set_top_light(light);
+    break;
+  default:
+    block.set_bot_light(light);
+    break;
+  }
+}
+} // namespace
+
+LightVolume::LightVolume() { clear(); }
+
+void LightVolume::clear() {
+  for (auto &volume : m_volumes) {
+    volume.fill(0);
+  }
+}
+
+void LightEngine::compute(Chunk &chunk) {
+  m_computed_chunk = &chunk;
+  m_mark_changes = false;
+  chunk.m_light.clear();
+
+  // Sky light shines down every column until it hits the highest block. Only
+  // the blocks next to a higher neighbouring column spread it sideways
+  for (int x = 0; x < block_width; x++) {
+    for (int z = 0; z < block_depth; z++) {
+      const auto height{static_cast<int>(chunk.get_column_height(x, z))};
+      const auto neighbourhood_height{chunk._get_neighbourhood_height(x, z)};
+      for (int y = height; y < block_height; y++) {
+        const Node node{&chunk,
+                        static_cast<uint16_t>(LightVolume::index(x, y, z))};
+        _set(node, LightVolume::SKY, max_light_level);
+        if (y < neighbourhood_height) {
+          m_queue.push_back(node);
+        }
+      }
+    }
+  }
+
+  // The light of the neighbouring chunks flows into this chunk. Only the
+  // border blocks of the neighbours which are brighter than the blocks next to
+  // them are queued. Both borders start at the given x and z and run along
+  // step
+  const auto queue_border{[&](const std::shared_ptr<Chunk> &neighbour,
+                              const glm::ivec2 &start,
+                              const glm::ivec2 &neighbour_start,
+                              const glm::ivec2 &step,
+                              const LightVolume::Channel channel) {
+    if (!neighbour) {
+      return;
+    }
+    for (int i = 0; i < block_width; i++) {
+      for (int y = 0; y < block_height; y++) {
+        const auto index{LightVolume::index(start.x + step.x * i, y,
+                                            start.y + step.y * i)};
+        const auto neighbour_index{
+            LightVolume::index(neighbour_start.x + step.x * i, y,
+                               neighbour_start.y + step.y * i)};
+        if (neighbour->m_light.get(channel, neighbour_index) >
+            chunk.m_light.get(channel, index) + 1) {
+          m_queue.push_back(
+              Node{neighbour.get(), static_cast<uint16_t>(neighbour_index)});
+        }
+      }
+    }
+  }};
+  const auto queue_borders{[&](const LightVolume::Channel channel) {
+    queue_border(chunk.get_left(), glm::ivec2(0, 0),
+                 glm::ivec2(block_width - 1, 0), glm::ivec2(0, 1), channel);
+    queue_border(chunk.get_right(), glm::ivec2(block_width - 1, 0),
+                 glm::ivec2(0, 0), glm::ivec2(0, 1), channel);
+    queue_border(chunk.get_front(), glm::ivec2(0, 0),
+                 glm::ivec2(0, block_depth - 1), glm::ivec2(1, 0), channel);
+    queue_border(chunk.get_back(), glm::ivec2(0, block_depth - 1),
+                 glm::ivec2(0, 0), glm::ivec2(1, 0), channel);
+  }};
+
+  queue_borders(LightVolume::SKY);
+  _propagate(LightVolume::SKY);
+
+  for (int x = 0; x < block_width; x++) {
+    for (int z = 0; z < block_depth; z++) {
+      chunk.get_column(x, z).for_each([&](const size_t y) {
+        const auto emission{block::get_light_emission(chunk.get(x, y, z))};
+        if (emission != 0) {
+          const Node node{&chunk,
+                          static_cast<uint16_t>(LightVolume::index(x, y, z))};
+          _set(node, LightVolume::BLOCK, emission);
+          m_queue.push_back(node);
+        }
+      });
+    }
+  }
+  queue_borders(LightVolume::BLOCK);
+  _propagate(LightVolume::BLOCK);
+
+  // Only the visible faces need to be lit
+  for (int x = 0; x < block_width; x++) {
+    for (int z = 0; z < block_depth; z++) {
+      chunk.get_column(x, z).for_each([&](const size_t y) {
+        const glm::ivec3 position(x, y, z);
+        const auto &block{chunk.get_block(x, y, z)};
+        if (block.front_face()) {
+          _update_face(chunk, position, Block::FRONT);
+        }
+        if (block.back_face()) {
+          _update_face(chunk, position, Block::BACK);
+        }
+        if (block.left_face()) {
+          _update_face(chunk, position, Block::LEFT);
+        }
+        if (block.right_face()) {
+          _update_face(chunk, position, Block::RIGHT);
+        }
+        if (block.top_face()) {
+          _update_face(chunk, position, Block::TOP);
+        }
+        if (block.bot_face()) {
+          _update_face(chunk, position, Block::BOT);
+        }
+      });
+    }
+  }
+
+  m_computed_chunk = nullptr;
+}
+
+void LightEngine::update(Chunk &chunk, const glm::ivec3 &position) {
+  m_computed_chunk = nullptr;
+  m_mark_changes = true;
+
+  const Node node{&chunk, static_cast<uint16_t>(LightVolume::index(
+                              position.x, position.y, position.z))};
+  const auto type{chunk.get(position.x, position.y, position.z)};
+
+  for (const auto channel : {LightVolume::SKY, LightVolume::BLOCK}) {
+    // The block loses its old light. Afterwards it receives the light of its
+    // neighbours again if it is transparent
+    if (const auto level{chunk.m_light.get(channel, node.index)}; level != 0) {
+      _set(node, channel, 0);
+      m_removal_queue.push_back(RemovalNode{node, level});
+      _remove(channel);
+    }
+
+    if (!block::is_opaque(type)) {
+      if (channel == LightVolume::SKY && position.y == block_height - 1) {
+        _set(node, channel, max_light_level);
+        m_queue.push_back(node);
+      }
+      for (const auto direction : directions) {
+        if (Node neighbour; _get_neighbour(node, direction, neighbour) &&
+                            neighbour.chunk->m_light.get(
+                                channel, neighbour.index) > 1) {
+          m_queue.push_back(neighbour);
+        }
+      }
+    }
+    if (channel == LightVolume::BLOCK) {
+      if (const auto emission{block::get_light_emission(type)};
+          emission != 0) {
+        _set(node, channel, emission);
+        m_queue.push_back(node);
+      }
+    }
+
+    _propagate(channel);
+  }
+
+  // The faces of the block and the faces pointing at it can have become
+  // visible
+  if (block::is_opaque(type)) {
+    _update_faces(chunk, position);
+  }
+  for (const auto direction : directions) {
+    Node neighbour;
+    if (!_get_neighbour(node, direction, neighbour)) {
+      continue;
+    }
+
+    const auto neighbour_position{to_position(neighbour.index)};
+    if (block::is_opaque(neighbour.chunk->get(neighbour_position.x,
+                                              neighbour_position.y,
+                                              neighbour_position.z))) {
+      _update_face(*neighbour.chunk, neighbour_position, opposite(direction));
+      neighbour.chunk->m_changed_sections.set(neighbour_position.y /
+                                              section_height);
+    }
+  }
+}
+
+bool LightEngine::_get_neighbour(const Node &node, const Direction direction,
+                                 Node &result) {
+  auto position{to_position(node.index)};
+  auto *chunk{node.chunk};
+
+  switch (direction) {
+  case Block::FRONT:
+    if (++position.z == block_depth) {
+      chunk = chunk->m_back.lock().get();
+      position.z = 0;
+    }
+    break;
+  case Block::BACK:
+    if (--position.z < 0) {
+      chunk = chunk->m_front.lock().get();
+      position.z = block_depth - 1;
+    }
+    break;
+  case Block::LEFT:
+    if (--position.x < 0) {
+      chunk = chunk->m_left.lock().get();
+      position.x = block_width - 1;
+    }
+    break;
+  case Block::RIGHT:
+    if (++position.x == block_width) {
+      chunk = chunk->m_right.lock().get();
+      position.x = 0;
+    }
+    break;
+  case Block::TOP:
+    if (++position.y == block_height) {
+      return false;
+    }
+    break;
+  default:
+    if (--position.y < 0) {
+      return false;
+    }
+    break;
+  }
+
+  if (!chunk) {
+    return false;
+  }
+
+  result.chunk = chunk;
+  result.index = static_cast<uint16_t>(
+      LightVolume::index(position.x, position.y, position.z));
+  return true;
+}
+
+void LightEngine::_update_face(Chunk &chunk, const glm::ivec3 &block,
+                               const Direction direction) {
+  uint8_t level;
+  if (Node neighbour; _get_neighbour(
+          Node{&chunk, static_cast<uint16_t>(
+                           LightVolume::index(block.x, block.y, block.z))},
+          direction, neighbour)) {
+    level = neighbour.chunk->m_light.get_max(neighbour.index);
+  } else {
+    // The sky is above the world. Faces towards chunks which are not loaded
+    // are lit fully to avoid dark borders
+    level = direction == Block::BOT ? 0 : max_light_level;
+  }
+
+  set_face_light(chunk.get_block(block.x, block.y, block.z), direction,
+                 to_face_light(level));
+}
+
+bool LightEngine::_is_emitting(const Node &node) {
+  const auto position{to_position(node.index)};
+  return block::get_light_emission(
+             node.chunk->get(position.x, position.y, position.z)) != 0;
+}
+
+void LightEngine::_update_faces(Chunk &chunk, const glm::ivec3 &block) {
+  for (const auto direction : directions) {
+    _update_face(chunk, block, direction);
+  }
+}
+
+void LightEngine::_set(const Node &node, const LightVolume::Channel channel,
+                       const uint8_t level) {
+  const auto old_max{node.chunk->m_light.get_max(node.index)};
+  node.chunk->m_light.set(channel, node.index, level);
+  if (node.chunk->m_light.get_max(node.index) == old_max) {
+    return;
+  }
+
+  // The faces of the computed chunk are updated at once afterwards. Only its
+  // border blocks light faces of the neighbouring chunks
+  if (const auto position{to_position(node.index)};
+      node.chunk == m_computed_chunk && position.x != 0 &&
+      position.x != block_width - 1 && position.z != 0 &&
+      position.z != block_depth - 1) {
+    return;
+  }
+
+  // The faces of the opaque neighbours pointing at this block are lit by it
+  for (const auto direction : directions) {
+    Node neighbour;
+    if (!_get_neighbour(node, direction, neighbour) ||
+        neighbour.chunk == m_computed_chunk) {
+      continue;
+    }
+
+    const auto position{to_position(neighbour.index)};
+    if (!block::is_opaque(
+            neighbour.chunk->get(position.x, position.y, position.z))) {
+      continue;
+    }
+
+    _update_face(*neighbour.chunk, position, opposite(direction));
+    if (m_mark_changes) {
+      neighbour.chunk->m_changed_sections.set(position.y / section_height);
+    } else {
+      neighbour.chunk->_mark_relit(position.y / section_height);
+    }
+  }
+}
+
+void LightEngine::_propagate(const LightVolume::Channel channel) {
+  for (size_t i = 0; i < m_queue.size(); i++) {
+    const auto node{m_queue[i]};
+    const auto level{node.chunk->m_light.get(channel, node.index)};
+
+    for (const auto direction : directions) {
+      const auto new_level{_spread(channel, direction, level)};
+      Node neighbour;
+      if (new_level == 0 || !_get_neighbour(node, direction, neighbour)) {
+        continue;
+      }
+
+      const auto position{to_position(neighbour.index)};
+      if (block::is_opaque(
+              neighbour.chunk->get(position.x, position.y, position.z)) ||
+          neighbour.chunk->m_light.get(channel, neighbour.index) >=
+              new_level) {
+        continue;
+      }
+
+      _set(neighbour, channel, new_level);
+      m_queue.push_back(neighbour);
+    }
+  }
+  m_queue.clear();
+}
+
+void LightEngine::_remove(const LightVolume::Channel channel) {
+  for (size_t i = 0; i < m_removal_queue.size(); i++) {
+    const auto [node, level] = m_removal_queue[i];
+
+    for (const auto direction : directions) {
+      Node neighbour;
+      if (!_get_neighbour(node, direction, neighbour)) {
+        continue;
+      }
+
+      const auto neighbour_level{
+          neighbour.chunk->m_light.get(channel, neighbour.index)};
+      if (neighbour_level == 0) {
+        continue;
+      }
+
+      // The neighbour got its light from this block if it is not brighter
+      // than the light this block has spread to it. Blocks which emit light
+      // keep it
+      if (neighbour_level <= _spread(channel, direction, level) &&
+          (channel == LightVolume::SKY || !_is_emitting(neighbour))) {
+        _set(neighbour, channel, 0);
+        m_removal_queue.push_back(RemovalNode{neighbour, neighbour_level});
+      } else {
+        m_queue.push_back(neighbour);
+      }
+    }
+  }
+  m_removal_queue.clear();
+}
+} // namespace chunk
@@ -0,0 +1,141 @@
+#pragma once
+#include "block.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace chunk {
+class Chunk;
+
+// The highest light level. Sky light has this level above the highest block of
+// a column
+constexpr uint8_t max_light_level = 15;
+
+// Returns the light of a face which borders a block with the light level.
+// Faces are never completely dark
+constexpr float to_face_light(const uint8_t level) {
+  return static_cast<float>(std::max(level, uint8_t(1))) /
+         static_cast<float>(max_light_level);
+}
+
+// Stores the light level of every block of a chunk as 4 bit values. Sky light
+// and block light are stored in separate volumes
+class LightVolume {
+public:
+  enum Channel {
+    SKY,
+    BLOCK,
+  };
+
+  static constexpr size_t block_count =
+      block_width * block_depth * block_height;
+
+  LightVolume();
+
+  inline uint8_t get(const Channel channel, const size_t index) const {
+    return (m_volumes[channel][index / 2] >> ((index & 1) * 4)) & 0b1111;
+  }
+  inline void set(const Channel channel, const size_t index,
+                  const uint8_t level) {
+    auto &value{m_volumes[channel][index / 2]};
+    const auto shift{(index & 1) * 4};
+    value = static_cast<uint8_t>((value & ~(0b1111 << shift)) |
+                                 (level << shift));
+  }
+  // Returns the brightest light of both channels
+  inline uint8_t get_max(const size_t index) const {
+    return std::max(get(SKY, index), get(BLOCK, index));
+  }
+  void clear();
+
+  static inline size_t index(const size_t x, const size_t y, const size_t z) {
+    return x + z * block_width + y * (block_width * block_depth);
+  }
+
+  inline size_t memory_usage() const { return sizeof(m_volumes); }
+
+private:
+  std::array<std::array<uint8_t, block_count / 2>, 2> m_volumes;
+};
+
+// Spreads sky light and block light through the blocks of the chunks with a
+// breadth first search. Light loses one level per block, except for sky light
+// at the highest level which travels down without losing any. The search
+// crosses the borders to the neighbouring chunks. Whenever the light of a
+// block changes the light of the faces of the surrounding blocks is updated
+class LightEngine {
+public:
+  // Computes the light of the whole chunk. Light of the neighbouring chunks
+  // flows into the chunk and its light flows into them. Every chunk which
+  // lies at most one chunk away can be written
+  void compute(Chunk &chunk);
+  // Updates the light after the block at position has been changed. Only the
+  // blocks whose light changes are visited. The sections whose faces have
+  // changed are marked as changed in their chunks
+  void update(Chunk &chunk, const glm::ivec3 &position);
+
+private:
+  // A block of a chunk
+  struct Node {
+    Chunk *chunk;
+    uint16_t index;
+  };
+  // A block whose light is removed and its light before the removal
+  struct RemovalNode {
+    Node node;
+    uint8_t level;
+  };
+
+  // The directions are named after the faces of a block pointing into them
+  using Direction = Block::Face;
+  static constexpr std::array<Direction, 6> directions{
+      Block::FRONT, Block::BACK, Block::LEFT,
+      Block::RIGHT, Block::TOP,  Block::BOT};
+
+  // Returns the light which arrives at a block coming from a block with level
+  // in direction
+  static inline uint8_t _spread(const LightVolume::Channel channel,
+                                const Direction direction,
+                                const uint8_t level) {
+    if (channel == LightVolume::SKY && direction == Block::BOT &&
+        level == max_light_level) {
+      return level;
+    }
+    return level == 0 ? 0 : level - 1;
+  }
+
+  // Writes the neighbour of node in direction into result. Returns false if
+  // there is none because it lies outside of the world or in a chunk which
+  // is not loaded
+  static bool _get_neighbour(const Node &node, const Direction direction,
+                             Node &result);
+  // Updates the light of the face of block which points towards the
+  // neighbouring block in direction
+  static void _update_face(Chunk &chunk, const glm::ivec3 &block,
+                           const Direction direction);
+  // Returns wether the block of node emits light
+  static bool _is_emitting(const Node &node);
+  // Updates the light of all faces of the block
+  static void _update_faces(Chunk &chunk, const glm::ivec3 &block);
+
+  // Sets the light of node and updates the faces of its neighbours
+  void _set(const Node &node, const LightVolume::Channel channel,
+            const uint8_t level);
+  // Spreads the light of every queued block
+  void _propagate(const LightVolume::Channel channel);
+  // Removes the light of every queued block and of all blocks which received
+  // their light from it. Blocks which are lit by other sources are queued to
+  // be propagated again
+  void _remove(const LightVolume::Channel channel);
+
+  std::vector<Node> m_queue;
+  std::vector<RemovalNode> m_removal_queue;
+  // The chunk whose light is computed by compute. Its faces are updated all at
+  // once afterwards
+  Chunk *m_computed_chunk{nullptr};
+  // Wether the sections with changed faces are marked as changed. Otherwise
+  // they are marked as relit which does not need the chunks to be locked
+  bool m_mark_changes{false};
+};
+} // namespace chunk
@@ -0,0 +1,245 @@
+#include "lod_terrain.hpp"
+#include "light.hpp"
+#include <cstdlib>
+
+namespace chunk {
+LodTerrain::Tile::Tile()
+    : step(0), wanted_step(0),
+      allocation(::core::vulkan::BufferArena::invalid_handle), num_faces(0),
+      next_allocation(::core::vulkan::BufferArena::invalid_handle),
+      next_num_faces(0), has_next_allocation(false), generating(false) {}
+
+LodTerrain::LodTerrain(::core::vulkan::BufferArena &arena,
+                       ::core::JobSystem &job_system,
+                       const block::Server &block_server,
+                       const world_gen::WorldGeneration &world_generation)
+    : m_center(0, 0), m_render_distance(-1), m_arena(arena),
+      m_job_system(job_system), m_block_server(block_server),
+      m_world_generation(world_generation) {}
+
+LodTerrain::~LodTerrain() { clear(); }
+
+void LodTerrain::update(const ChunkMap::Position &center,
+                        const int render_distance) {
+  if (center == m_center && render_distance == m_render_distance) {
+    return;
+  }
+  m_center = center;
+  m_render_distance = render_distance;
+
+  const auto distance{get_distance(render_distance)};
+  const auto distance_to_center = [&](const ChunkMap::Position &pos) {
+    return std::max(std::abs(pos.first - center.first),
+                    std::abs(pos.second - center.second));
+  };
+
+  // The tiles start at the outermost ring of chunks so that they fill the
+  // gaps while the chunks of the ring are loaded
+  for (auto it = m_tiles.begin(); it != m_tiles.end();) {
+    const auto d{distance_to_center(it->first)};
+    if (d >= render_distance && d <= distance) {
+      it->second->wanted_step = _get_step(d, render_distance);
+      it++;
+      continue;
+    }
+
+    _free(*it->second);
+    if (!it->second->job.is_done()) {
+      m_removed_tiles.push_back(std::move(it->second));
+    }
+    it = m_tiles.erase(it);
+  }
+
+  for (int x = -distance; x <= distance; x++) {
+    for (int z = -distance; z <= distance; z++) {
+      const ChunkMap::Position pos(center.first + x, center.second + z);
+      const auto d{distance_to_center(pos)};
+      if (d < render_distance || m_tiles.count(pos) != 0) {
+        continue;
+      }
+
+      auto tile{std::make_unique<Tile>()};
+      tile->wanted_step = _get_step(d, render_distance);
+      m_tiles.emplace(pos, std::move(tile));
+    }
+  }
+}
+
+void LodTerrain::add_draws(MeshRenderer &renderer,
+                           const physics::Frustum &frustum,
+                           const ChunkMap &chunks) {
+  m_removed_tiles.erase(
+      std::remove_if(m_removed_tiles.begin(), m_removed_tiles.end(),
+                     [](const std::unique_ptr<Tile> &tile) {
+                       return tile->job.is_done();
+                     }),
+      m_removed_tiles.end());
+
+  size_t uploads{0};
+  for (auto &[pos, tile_ptr] : m_tiles) {
+    auto &tile{*tile_ptr};
+    const glm::ivec2 origin(pos.first * block_width, pos.second * block_depth);
+
+    if (tile.generating && uploads < max_uploads_per_frame &&
+        tile.job.is_done()) {
+      // The current mesh is rendered until the new one has been uploaded
+      m_arena.free(tile.next_allocation);
+      tile.next_allocation = ::core::vulkan::BufferArena::invalid_handle;
+      tile.has_next_allocation = true;
+
+      tile.next_allocation = m_arena.allocate(
+          tile.vertices.data(), sizeof(Vertex) * tile.vertices.size());
+      tile.next_num_faces = static_cast<uint32_t>(tile.vertices.size() /
+                                                  Block::vertices_per_face);
+
+      // The tiles keep no memory on the CPU
+      std::vector<Vertex>().swap(tile.vertices);
+      tile.generating = false;
+      uploads++;
+    }
+
+    if (!tile.generating && tile.step != tile.wanted_step) {
+      tile.step = tile.wanted_step;
+      tile.generating = true;
+      tile.job = m_job_system.submit(
+          [this, &tile, origin, step = tile.step]() {
+            _generate(m_block_server, m_world_generation, origin, step,
+                      tile.vertices);
+          },
+          ::core::JobSystem::Priority::LOW);
+    }
+
+    if (tile.has_next_allocation &&
+        (tile.next_allocation == ::core::vulkan::BufferArena::invalid_handle ||
+         m_arena.is_ready(tile.next_allocation))) {
+      m_arena.free(tile.allocation);
+      tile.allocation = tile.next_allocation;
+      tile.num_faces = tile.next_num_faces;
+      tile.next_allocation = ::core::vulkan::BufferArena::invalid_handle;
+      tile.has_next_allocation = false;
+    }
+
+    if (tile.allocation == ::core::vulkan::BufferArena::invalid_handle ||
+        chunks.contains(pos)) {
+      continue;
+    }
+
+    if (!frustum.intersects(physics::AABB(
+            static_cast<float>(origin.x), 0.0f, static_cast<float>(origin.y),
+            static_cast<float>(block_width), static_cast<float>(block_height),
+            static_cast<float>(block_depth)))) {
+      renderer.add_culled();
+      continue;
+    }
+
+    renderer.add_faces(m_arena.get_range(tile.allocation), tile.num_faces,
+                       renderer.add_instance(origin));
+  }
+}
+
+void LodTerrain::clear() {
+  std::vector<::core::JobSystem::Handle> jobs;
+  for (const auto &[pos, tile] : m_tiles) {
+    jobs.emplace_back(tile->job);
+  }
+  for (const auto &tile : m_removed_tiles) {
+    jobs.emplace_back(tile->job);
+  }
+  // A failed job has already been logged by the worker and only leaves a tile
+  // without a mesh behind, which is removed anyway
+  try {
+    ::core::JobSystem::wait_all(jobs);
+  } catch (...) {
+  }
+
+  for (auto &[pos, tile] : m_tiles) {
+    _free(*tile);
+  }
+  m_tiles.clear();
+  m_removed_tiles.clear();
+  m_render_distance = -1;
+}
+
+int LodTerrain::_get_step(const int distance, const int render_distance) {
+  if (distance <= render_distance * 2) {
+    return 2;
+  }
+  if (distance <= render_distance * 3) {
+    return 4;
+  }
+  return 8;
+}
+
+void LodTerrain::_generate(const block::Server &block_server,
+                           const world_gen::WorldGeneration &world_generation,
+                           const glm::ivec2 &origin, const int step,
+                           std::vector<Vertex> &vertices) {
+  static_assert(block_width == block_depth, "tiles need to be square");
+
+  const auto cells{block_width / step};
+  // The heights of the cells of the tile and one additional cell on every side
+  // which belongs to the neighbouring tiles
+  const auto size{cells + 2};
+  // Every cell takes the height of its center column
+  std::vector<size_t> column_heights(size * size);
+  world_generation.get_heights(origin - glm::ivec2(step - step / 2), size,
+                               size, step, column_heights.data());
+  std::vector<int> heights(size * size);
+  std::transform(column_heights.begin(), column_heights.end(),
+                 heights.begin(), [](const size_t height) {
+                   return std::min(static_cast<int>(height), block_height);
+                 });
+  const auto height_at = [&](const int x, const int z) {
+    return heights[(x + 1) + (z + 1) * size];
+  };
+
+  const auto &tiles{block_server.get_texture_tiles(block::Type::GRASS)};
+  // Every face of a tile borders the air above the highest block of a column.
+  // The sky light reaches it without losing a level, so the faces of the
+  // chunks at the surface are lit the same. Only the faces below overhangs
+  // are darker in the chunks, which the heights do not contain
+  constexpr auto light{to_face_light(max_light_level)};
+
+  for (int z = 0; z < cells; z++) {
+    for (int x = 0; x < cells; x++) {
+      const auto height{height_at(x, z)};
+      if (height == 0) {
+        continue;
+      }
+
+      const glm::ivec3 from(x * step, 0, z * step);
+      const glm::ivec3 to(from.x + step, height, from.z + step);
+      Block::create_face(vertices, Block::Face::TOP, from, to, tiles.top,
+                         light);
+
+      // The sides facing lower neighbours. On the border of the tile they
+      // reach one step further down to cover the gaps to tiles with a
+      // different step or to chunks
+      const auto side = [&](const Block::Face face, const int nx, const int nz,
+                            const bool border, const uint32_t tile) {
+        auto bottom{height_at(nx, nz)};
+        if (border) {
+          bottom = std::max(std::min(bottom, height) - step, 0);
+        }
+        if (bottom >= height) {
+          return;
+        }
+        Block::create_face(vertices, face, glm::ivec3(from.x, bottom, from.z),
+                           to, tile, light);
+      };
+      side(Block::Face::FRONT, x, z + 1, z == cells - 1, tiles.front);
+      side(Block::Face::BACK, x, z - 1, z == 0, tiles.back);
+      side(Block::Face::LEFT, x - 1, z, x == 0, tiles.left);
+      side(Block::Face::RIGHT, x + 1, z, x == cells - 1, tiles.right);
+    }
+  }
+}
+
+void LodTerrain::_free(Tile &tile) {
+  m_arena.free(tile.allocation);
+  m_arena.free(tile.next_allocation);
+  tile.allocation = ::core::vulkan::BufferArena::invalid_handle;
+  tile.next_allocation = ::core::vulkan::BufferArena::invalid_handle;
+  tile.has_next_allocation = false;
+}
+} // namespace chunk
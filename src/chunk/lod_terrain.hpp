@@ -0,0 +1,107 @@
+#pragma once
+#include "../core/job_system.hpp"
+#include "../core/vulkan/buffer_arena.hpp"
+#include "../physics/frustum.hpp"
+#include "../world_gen/world_generation.hpp"
+#include "chunk_map.hpp"
+#include "mesh_renderer.hpp"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace chunk {
+// Renders the terrain beyond the loaded chunks with coarse meshes which are
+// generated from the heights of the world generation. No blocks are stored
+// for it. The terrain is split into tiles of the size of a chunk. The further
+// away a tile is from the center the more columns are merged into one
+class LodTerrain {
+public:
+  // The terrain reaches this many times further than the chunks
+  static constexpr int distance_factor = 4;
+  // The maximum distance of the terrain in chunks. It keeps the terrain in
+  // front of the far plane
+  static constexpr int max_distance = 60;
+
+  // The meshes are generated on the workers of job_system and uploaded into
+  // arena
+  LodTerrain(::core::vulkan::BufferArena &arena, ::core::JobSystem &job_system,
+             const block::Server &block_server,
+             const world_gen::WorldGeneration &world_generation);
+  ~LodTerrain();
+
+  LodTerrain(const LodTerrain &) = delete;
+  LodTerrain &operator=(const LodTerrain &) = delete;
+
+  // Returns how far the terrain reaches in chunks
+  static inline int get_distance(const int render_distance) {
+    return std::min(render_distance * distance_factor, max_distance);
+  }
+
+  // Adds and removes the tiles around the chunk position center and
+  // regenerates the tiles whose level of detail does not match their
+  // distance anymore. Does nothing if neither center nor render_distance have
+  // changed
+  void update(const ChunkMap::Position &center, const int render_distance);
+  // Uploads the finished meshes and adds the draws of the tiles inside of
+  // frustum which are not covered by one of chunks
+  void add_draws(MeshRenderer &renderer, const physics::Frustum &frustum,
+                 const ChunkMap &chunks);
+  // Removes all tiles. Waits for the running jobs
+  void clear();
+
+  inline size_t get_tile_count() const { return m_tiles.size(); }
+
+private:
+  // How many tile meshes are uploaded in one frame at most
+  static constexpr size_t max_uploads_per_frame = 16;
+
+  struct Tile {
+    Tile();
+
+    // The number of columns merged along each axis of the generated vertices
+    int step;
+    // The step the tile should have at its distance
+    int wanted_step;
+
+    // The uploaded vertices which are rendered
+    ::core::vulkan::BufferArena::Handle allocation;
+    uint32_t num_faces;
+    // Replaces allocation as soon as its upload has finished
+    ::core::vulkan::BufferArena::Handle next_allocation;
+    uint32_t next_num_faces;
+    bool has_next_allocation;
+
+    // The job which generates vertices
+    ::core::JobSystem::Handle job;
+    // Wether vertices have been generated that are not uploaded yet
+    bool generating;
+    std::vector<Vertex> vertices;
+  };
+
+  // Returns how many columns are merged along each axis of a tile at distance
+  // in chunks from the center
+  static int _get_step(const int distance, const int render_distance);
+  // Generates the mesh of the tile whose corner is at the world position
+  // origin. Every step x step columns are merged into one with the height of
+  // their center
+  static void _generate(const block::Server &block_server,
+                        const world_gen::WorldGeneration &world_generation,
+                        const glm::ivec2 &origin, const int step,
+                        std::vector<Vertex> &vertices);
+
+  // Frees the allocations of tile
+  void _free(Tile &tile);
+
+  std::map<ChunkMap::Position, std::unique_ptr<Tile>> m_tiles;
+  // Removed tiles whose job is still running
+  std::vector<std::unique_ptr<Tile>> m_removed_tiles;
+  ChunkMap::Position m_center;
+  int m_render_distance;
+
+  ::core::vulkan::BufferArena &m_arena;
+  ::core::JobSystem &m_job_system;
+  const block::Server &m_block_server;
+  const world_gen::WorldGeneration &m_world_generation;
+};
+} // namespace chunk
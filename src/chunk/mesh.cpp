@@ -1,5 +1,6 @@
 #include "mesh.hpp"
 #include "../core/log.hpp"
+#include "../core/profiler.hpp"
 #include "chunk.hpp"
 #include <array>
 #include <cstdlib>
@@ -10,68 +11,219 @@
 
 namespace chunk {
 
-Mesh::Mesh(const ::core::vulkan::Context &context)
-    : m_num_indices(-1), m_context(context) {}
+Mesh::SectionMesh::SectionMesh() : num_vertices(-1), generated(false) {}
 
-void Mesh::render(const ::core::vulkan::RenderCall &render_call) {
-  if (!m_vertex_buffer)
-    return;
+Mesh::Mesh() : m_mode(Mode::CULLED) {}
 
-  m_vertex_buffer->bind(render_call);
-  m_index_buffer->bind(render_call);
-  render_call.render_indices(m_num_indices);
+void Mesh::generate_vertices(const block::Server &block_server,
+                             const Chunk *chunk, const SectionMask &sections) {
+  VULKANKRAFT_PROFILE_ZONE("Mesh::generate_vertices");
+  for (size_t s = 0; s < section_count; s++) {
+    if (!sections[s]) {
+      continue;
+    }
+
+    auto &mesh{m_sections[s]};
+    mesh.vertices.clear();
+    mesh.generated = true;
+    mesh.visibility = SectionVisibility::compute(*chunk, s);
+
+    // Sections without air and whose neighbours also don't have air have no
+    // visible faces
+    if (const auto &section{chunk->get_section(s)};
+        section.is_empty() || chunk->is_section_sealed(s)) {
+      continue;
+    }
+
+    if (mesh.num_vertices != -1) {
+      mesh.vertices.reserve(mesh.num_vertices);
+    } else {
+      mesh.vertices.reserve(default_section_face_count *
+                            Block::vertices_per_face);
+    }
+
+    switch (m_mode) {
+    case Mode::CULLED:
+      _generate_culled_vertices(block_server, chunk, s, mesh);
+      break;
+    case Mode::GREEDY:
+      _generate_greedy_vertices(block_server, chunk, s, mesh);
+      break;
+    }
+  }
 }
 
-void Mesh::generate_vertices(const block::Server &block_server, Chunk *chunk,
-                             const glm::vec2 &pos) {
-  if (m_num_indices != -1) {
-    m_vertices.reserve(m_num_indices / Block::indices_per_face *
-                       Block::vertices_per_face);
-    m_indices.reserve(m_num_indices);
-  } else {
-    m_vertices.reserve(Block::default_face_count * Block::vertices_per_face);
-    m_indices.reserve(Block::default_face_count * Block::indices_per_face);
+void Mesh::clear_vertices(const SectionMask &sections) {
+  for (size_t s = 0; s < section_count; s++) {
+    if (sections[s]) {
+      m_sections[s].vertices.clear();
+      m_sections[s].generated = false;
+    }
   }
+}
+
+void Mesh::release_vertices(const size_t section) {
+  auto &mesh{m_sections[section]};
+  mesh.num_vertices = static_cast<uint32_t>(mesh.vertices.size());
+  mesh.vertices.clear();
+  mesh.generated = false;
+}
+
+void Mesh::_generate_culled_vertices(const block::Server &block_server,
+                                     const Chunk *chunk, const size_t section,
+                                     SectionMesh &mesh) {
+  const auto y_offset{section * section_height};
+  // Only the outer blocks of a full section can have visible faces
+  const auto full{chunk->get_section(section).is_full()};
 
   for (size_t x = 0; x < block_width; x++) {
     for (size_t z = 0; z < block_depth; z++) {
-      for (size_t y = 0; y < block_height; y++) {
-        if (auto &block = chunk->get_block(x, y, z);
-            block.type != block::Type::AIR) {
-          block.generate(block_server, m_vertices, m_indices,
-                         glm::vec3(static_cast<float>(x) + pos.x + 0.5f,
-                                   static_cast<float>(y) + 0.0f + 0.5f,
-                                   static_cast<float>(z) + pos.y + 0.5f));
+      for (size_t y = y_offset; y < y_offset + section_height; y++) {
+        if (full && is_inner_section_block(x, y, z)) {
+          continue;
+        }
+
+        if (const auto type = chunk->get(x, y, z); type != block::Type::AIR) {
+          chunk->get_block(x, y, z).generate(block_server, type, mesh.vertices,
+                                             glm::ivec3(x, y, z));
         }
       }
     }
   }
 }
 
-void Mesh::load_buffer() {
-  const auto vertices_size{sizeof(Vertex) * m_vertices.size()};
-  const auto indices_size{sizeof(uint32_t) * m_indices.size()};
-
-  if (vertices_size == 0) {
-    m_vertex_buffer.reset();
-    m_index_buffer.reset();
-  } else {
-    if (!m_vertex_buffer) {
-      m_vertex_buffer = std::make_unique<::core::vulkan::Buffer>(
-          m_context, vk::BufferUsageFlagBits::eVertexBuffer, vertices_size);
-    }
+void Mesh::_generate_greedy_vertices(const block::Server &block_server,
+                                     const Chunk *chunk, const size_t section,
+                                     SectionMesh &mesh) {
+  constexpr glm::ivec3 dimensions(block_width, section_height, block_depth);
+  const auto y_offset{static_cast<int>(section * section_height)};
+  constexpr FaceMask empty_mask{block::Type::AIR, 0.0f};
+
+  std::vector<FaceMask> mask;
 
-    if (!m_index_buffer) {
-      m_index_buffer = std::make_unique<::core::vulkan::Buffer>(
-          m_context, vk::BufferUsageFlagBits::eIndexBuffer, indices_size);
+  for (int f = Block::Face::FRONT; f <= Block::Face::BOT; f++) {
+    const auto face{static_cast<Block::Face>(f)};
+
+    // d ... the axis the face is pointing along
+    // u ... the first axis of the plane of the face
+    // v ... the second axis of the plane of the face
+    int d, u, v;
+    bool positive;
+    switch (face) {
+    case Block::Face::FRONT:
+    case Block::Face::BACK:
+      d = 2, u = 0, v = 1;
+      positive = face == Block::Face::FRONT;
+      break;
+    case Block::Face::RIGHT:
+    case Block::Face::LEFT:
+      d = 0, u = 2, v = 1;
+      positive = face == Block::Face::RIGHT;
+      break;
+    default:
+      d = 1, u = 0, v = 2;
+      positive = face == Block::Face::TOP;
+      break;
     }
 
-    m_vertex_buffer->set_data(m_vertices.data(), vertices_size);
-    m_index_buffer->set_data(m_indices.data(), indices_size);
-    m_num_indices = m_indices.size();
-  }
+    mask.assign(dimensions[u] * dimensions[v], empty_mask);
+
+    glm::ivec3 b;
+    for (b[d] = 0; b[d] < dimensions[d]; b[d]++) {
+      // Build the mask of all visible faces of this slice
+      for (b[v] = 0; b[v] < dimensions[v]; b[v]++) {
+        for (b[u] = 0; b[u] < dimensions[u]; b[u]++) {
+          auto &m{mask[b[u] + b[v] * dimensions[u]]};
+          m = empty_mask;
+
+          const auto type{chunk->get(b.x, b.y + y_offset, b.z)};
+          if (type == block::Type::AIR) {
+            continue;
+          }
+
+          const auto &block{chunk->get_block(b.x, b.y + y_offset, b.z)};
+          switch (face) {
+          case Block::Face::FRONT:
+            m = block.front_face() ? FaceMask{type, block.front_light()} : m;
+            break;
+          case Block::Face::BACK:
+            m = block.back_face() ? FaceMask{type, block.back_light()} : m;
+            break;
+          case Block::Face::LEFT:
+            m = block.left_face() ? FaceMask{type, block.left_light()} : m;
+            break;
+          case Block::Face::RIGHT:
+            m = block.right_face() ? FaceMask{type, block.right_light()} : m;
+            break;
+          case Block::Face::TOP:
+            m = block.top_face() ? FaceMask{type, block.top_light()} : m;
+            break;
+          case Block::Face::BOT:
+            m = block.bot_face() ? FaceMask{type, block.bot_light()} : m;
+            break;
+          }
+        }
+      }
+
+      // Merge the faces of the mask into as large as possible quads
+      for (int j = 0; j < dimensions[v]; j++) {
+        for (int i = 0; i < dimensions[u];) {
+          const auto current{mask[i + j * dimensions[u]]};
+          if (current == empty_mask) {
+            i++;
+            continue;
+          }
+
+          int width{1};
+          while (i + width < dimensions[u] &&
+                 mask[i + width + j * dimensions[u]] == current) {
+            width++;
+          }
 
-  m_vertices.clear();
-  m_indices.clear();
+          int height{1};
+          for (; j + height < dimensions[v]; height++) {
+            bool row_matches{true};
+            for (int k = 0; k < width; k++) {
+              if (!(mask[i + k + (j + height) * dimensions[u]] == current)) {
+                row_matches = false;
+                break;
+              }
+            }
+            if (!row_matches) {
+              break;
+            }
+          }
+
+          glm::ivec3 from, to;
+          from[d] = to[d] = b[d] + positive;
+          from[u] = i;
+          to[u] = i + width;
+          from[v] = j;
+          to[v] = j + height;
+          from.y += y_offset;
+          to.y += y_offset;
+
+          const auto &tiles{block_server.get_texture_tiles(current.type)};
+          const auto tile{face == Block::Face::FRONT   ? tiles.front
+                          : face == Block::Face::BACK  ? tiles.back
+                          : face == Block::Face::LEFT  ? tiles.left
+                          : face == Block::Face::RIGHT ? tiles.right
+                          : face == Block::Face::TOP   ? tiles.top
+                                                       : tiles.bot};
+
+          Block::create_face(mesh.vertices, face, from, to, tile,
+                             current.light);
+
+          for (int h = 0; h < height; h++) {
+            for (int k = 0; k < width; k++) {
+              mask[i + k + (j + h) * dimensions[u]] = empty_mask;
+            }
+          }
+          i += width;
+        }
+      }
+    }
+  }
 }
+
 }; // namespace chunk
\ No newline at end of file
@@ -1,34 +1,96 @@
 #pragma once
 #include "../block/server.hpp"
-#include "../core/resource_hodler.hpp"
-#include "../core/shader.hpp"
-#include "../core/vulkan/buffer.hpp"
 #include "block.hpp"
+#include "section_visibility.hpp"
+#include <array>
+#include <atomic>
 #include <glm/glm.hpp>
-#include <memory>
+#include <vector>
 
 namespace chunk {
 
 class Chunk;
 
+// Generates the vertices of the sections of a chunk on the CPU. They are
+// uploaded to the GPU by a MeshBuffer
 class Mesh {
 public:
-  Mesh(const ::core::vulkan::Context &context);
+  // Determines how the vertices of a chunk are generated
+  enum Mode {
+    // One quad for every visible face of a block
+    CULLED,
+    // Coplanar visible faces with the same block type and light get merged
+    // into larger quads
+    GREEDY,
+  };
 
-  void render(const ::core::vulkan::RenderCall &render_call);
+  Mesh();
 
-  void generate_vertices(const block::Server &block_server, Chunk *chunk,
-                         const glm::vec2 &pos);
+  // Generate the vertices of the given sections of chunk. The other sections
+  // keep their current vertices
+  void generate_vertices(const block::Server &block_server, const Chunk *chunk,
+                         const SectionMask &sections = SectionMask().set());
+  // Clears the generated vertices of the given sections
+  void clear_vertices(const SectionMask &sections = SectionMask().set());
+  // Clears the vertices of the section after they have been taken by a
+  // MeshBuffer. The amount of vertices is kept to reserve memory for the next
+  // generation
+  void release_vertices(const size_t section);
 
-  void load_buffer();
+  // Returns wether vertices of the section have been generated since they
+  // have been cleared or released
+  inline bool is_generated(const size_t section) const {
+    return m_sections[section].generated;
+  }
+  inline const std::vector<Vertex> &get_vertices(const size_t section) const {
+    return m_sections[section].vertices;
+  }
+  // Returns which faces of the section are connected. It is computed together
+  // with the vertices
+  inline const SectionVisibility &get_visibility(const size_t section) const {
+    return m_sections[section].visibility;
+  }
+
+  inline void set_mode(const Mode mode) { m_mode = mode; }
+  inline Mode get_mode() const { return m_mode; }
 
 private:
-  std::unique_ptr<::core::vulkan::Buffer> m_vertex_buffer;
-  std::unique_ptr<::core::vulkan::Buffer> m_index_buffer;
-  uint32_t m_num_indices;
+  // One entry of the 2D mask used by the greedy mesher
+  struct FaceMask {
+    block::Type type;
+    float light;
+
+    inline bool operator==(const FaceMask &other) const {
+      return type == other.type && light == other.light;
+    }
+  };
+
+  // The generated vertices of one section
+  struct SectionMesh {
+    SectionMesh();
+
+    // The amount of vertices of the last released generation
+    uint32_t num_vertices;
+    SectionVisibility visibility;
+
+    std::vector<Vertex> vertices;
+    // Wether vertices have been generated that have not been released yet
+    bool generated;
+  };
+
+  // How many faces are reserved for a section that has never been generated
+  static constexpr size_t default_section_face_count =
+      (block_width * block_depth) * 2 + (section_height * block_width) * 2 +
+      (section_height * block_depth) * 2;
+
+  void _generate_culled_vertices(const block::Server &block_server,
+                                 const Chunk *chunk, const size_t section,
+                                 SectionMesh &mesh);
+  void _generate_greedy_vertices(const block::Server &block_server,
+                                 const Chunk *chunk, const size_t section,
+                                 SectionMesh &mesh);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<uint32_t> m_indices;
-  const ::core::vulkan::Context &m_context;
+  std::array<SectionMesh, section_count> m_sections;
+  std::atomic<Mode> m_mode;
 };
 } // namespace chunk
@@ -0,0 +1,88 @@
+#include "mesh_buffer.hpp"
+#include <limits>
+
+namespace chunk {
+MeshBuffer::SectionBuffer::SectionBuffer()
+    : allocation(::core::vulkan::BufferArena::invalid_handle), num_faces(0) {}
+
+MeshBuffer::SectionBuffers::SectionBuffers() : has_next_buffer(false) {}
+
+MeshBuffer::MeshBuffer(::core::vulkan::BufferArena &arena) : m_arena(arena) {}
+
+MeshBuffer::~MeshBuffer() {
+  for (const auto &section : m_sections) {
+    m_arena.free(section.buffer.allocation);
+    m_arena.free(section.next_buffer.allocation);
+  }
+}
+
+void MeshBuffer::load(Mesh &mesh) {
+  for (size_t s = 0; s < section_count; s++) {
+    if (!mesh.is_generated(s)) {
+      continue;
+    }
+
+    auto &section{m_sections[s]};
+    const auto &vertices{mesh.get_vertices(s)};
+    section.visibility = mesh.get_visibility(s);
+
+    // The current buffer is rendered until the new one has been uploaded.
+    // A new buffer whose upload has not finished yet is replaced directly
+    m_arena.free(section.next_buffer.allocation);
+    section.next_buffer = SectionBuffer();
+    section.has_next_buffer = true;
+
+    if (!vertices.empty()) {
+      // The indices are the same for all faces and are not uploaded
+      section.next_buffer.allocation =
+          m_arena.allocate(vertices.data(), sizeof(Vertex) * vertices.size());
+      section.next_buffer.num_faces =
+          static_cast<uint32_t>(vertices.size() / Block::vertices_per_face);
+    }
+
+    mesh.release_vertices(s);
+  }
+}
+
+void MeshBuffer::add_draws(MeshRenderer &renderer, const glm::ivec2 &origin,
+                           const SectionMask &frustum_sections,
+                           const SectionMask &visible_sections) {
+  // The origin is only added once the first section with vertices is found
+  auto instance{std::numeric_limits<uint32_t>::max()};
+
+  for (size_t i = 0; i < m_sections.size(); i++) {
+    auto &section{m_sections[i]};
+    // The old allocation is still used by the frames in flight and is only
+    // reused by the arena after they have finished
+    if (section.has_next_buffer &&
+        (section.next_buffer.allocation ==
+             ::core::vulkan::BufferArena::invalid_handle ||
+         m_arena.is_ready(section.next_buffer.allocation))) {
+      m_arena.free(section.buffer.allocation);
+      section.buffer = section.next_buffer;
+      section.next_buffer = SectionBuffer();
+      section.has_next_buffer = false;
+    }
+
+    const auto &buffer{section.buffer};
+    if (buffer.allocation == ::core::vulkan::BufferArena::invalid_handle)
+      continue;
+
+    if (!frustum_sections[i]) {
+      renderer.add_culled();
+      continue;
+    }
+    if (!visible_sections[i]) {
+      renderer.add_occluded();
+      continue;
+    }
+
+    if (instance == std::numeric_limits<uint32_t>::max()) {
+      instance = renderer.add_instance(origin);
+    }
+
+    renderer.add_faces(m_arena.get_range(buffer.allocation), buffer.num_faces,
+                       instance);
+  }
+}
+} // namespace chunk
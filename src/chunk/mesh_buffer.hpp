@@ -0,0 +1,62 @@
+#pragma once
+#include "../core/vulkan/buffer_arena.hpp"
+#include "mesh.hpp"
+#include "mesh_renderer.hpp"
+#include <array>
+#include <glm/glm.hpp>
+
+namespace chunk {
+// Owns the uploaded vertices of the sections of a chunk. The vertices of every
+// section are allocated from arena
+class MeshBuffer {
+public:
+  MeshBuffer(::core::vulkan::BufferArena &arena);
+  ~MeshBuffer();
+
+  MeshBuffer(const MeshBuffer &) = delete;
+  MeshBuffer &operator=(const MeshBuffer &) = delete;
+
+  // Uploads the vertices of all sections of mesh that have been generated
+  // since the last call and releases them from mesh
+  void load(Mesh &mesh);
+  // Adds a draw for every visible section with vertices to renderer using
+  // origin as the world position of the chunk. The sections inside of the
+  // frustum which are not visible are counted as occluded
+  void add_draws(MeshRenderer &renderer, const glm::ivec2 &origin,
+                 const SectionMask &frustum_sections,
+                 const SectionMask &visible_sections);
+
+  // Returns which faces of the section are connected. It is updated together
+  // with the vertices by load
+  inline const SectionVisibility &get_visibility(const size_t section) const {
+    return m_sections[section].visibility;
+  }
+
+private:
+  // The uploaded vertices of a section
+  struct SectionBuffer {
+    SectionBuffer();
+
+    ::core::vulkan::BufferArena::Handle allocation;
+    uint32_t num_faces;
+  };
+
+  // The buffers of one section
+  struct SectionBuffers {
+    SectionBuffers();
+
+    // The buffer which is rendered
+    SectionBuffer buffer;
+    // The buffer which replaces buffer as soon as its upload has finished
+    SectionBuffer next_buffer;
+    bool has_next_buffer;
+
+    // The visibility of the loaded vertices
+    SectionVisibility visibility;
+  };
+
+  std::array<SectionBuffers, section_count> m_sections;
+
+  ::core::vulkan::BufferArena &m_arena;
+};
+} // namespace chunk
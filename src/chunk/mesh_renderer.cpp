@@ -0,0 +1,115 @@
+#include "mesh_renderer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace chunk {
+MeshRenderer::MeshRenderer(const ::core::vulkan::Context &context,
+                           const ::core::vulkan::BufferArena &arena)
+    : m_quad_indices(context, vk::BufferUsageFlagBits::eIndexBuffer,
+                     sizeof(uint16_t) * max_face_count *
+                         Block::indices_per_face,
+                     _generate_quad_indices().data()),
+      m_frame_buffers(context.get_swap_chain_image_count()),
+      m_culled_count(0), m_occluded_count(0), m_draw_call_count(0),
+      m_multi_draw(
+          context.get_physical_device_info().features.multiDrawIndirect),
+      m_indirect_first_instance(context.get_physical_device_info()
+                                    .features.drawIndirectFirstInstance),
+      m_arena(arena), m_context(context) {}
+
+void MeshRenderer::clear() {
+  m_draws.clear();
+  m_instances.clear();
+  m_culled_count = 0;
+  m_occluded_count = 0;
+}
+
+void MeshRenderer::render(const ::core::vulkan::RenderCall &render_call) {
+  m_draw_call_count = 0;
+  if (m_draws.empty()) {
+    return;
+  }
+
+  // Every buffer of the arena needs to be bound for its draws, so the draws
+  // of one buffer are put next to each other
+  std::stable_sort(m_draws.begin(), m_draws.end(),
+                   [](const Draw &lhs, const Draw &rhs) {
+                     return lhs.buffer < rhs.buffer;
+                   });
+
+  const auto commands_size{sizeof(vk::DrawIndexedIndirectCommand) *
+                           m_draws.size()};
+  const auto instances_size{sizeof(glm::ivec2) * m_instances.size()};
+  m_data.resize(commands_size + instances_size);
+  for (size_t i = 0; i < m_draws.size(); i++) {
+    memcpy(m_data.data() + i * sizeof(vk::DrawIndexedIndirectCommand),
+           &m_draws[i].command, sizeof(vk::DrawIndexedIndirectCommand));
+  }
+  memcpy(m_data.data() + commands_size, m_instances.data(), instances_size);
+
+  // The buffer is only used by the frame of this swap chain image which has
+  // finished before it is rendered again
+  auto &buffer{m_frame_buffers[render_call.get_swap_chain_image_index()]};
+  if (!buffer || buffer->get_size() < m_data.size()) {
+    // Grow with some headroom so that the buffer is not recreated while more
+    // chunks get loaded
+    const auto size{std::max(m_data.size(), buffer ? buffer->get_size() * 2
+                                                   : m_data.size())};
+    buffer = std::make_unique<::core::vulkan::Buffer>(
+        m_context,
+        vk::BufferUsageFlagBits::eIndirectBuffer |
+            vk::BufferUsageFlagBits::eVertexBuffer,
+        size);
+  }
+  buffer->write(m_data.data(), m_data.size());
+
+  render_call.bind_vertex_buffer(buffer->get_handle(), 1, commands_size);
+  render_call.bind_index_buffer(m_quad_indices.get_handle(),
+                                vk::IndexType::eUint16);
+
+  for (size_t begin = 0; begin < m_draws.size();) {
+    const auto arena_buffer{m_draws[begin].buffer};
+    size_t end{begin + 1};
+    while (end < m_draws.size() && m_draws[end].buffer == arena_buffer) {
+      end++;
+    }
+
+    m_arena.bind(render_call, arena_buffer);
+
+    if (m_indirect_first_instance && m_multi_draw) {
+      render_call.render_indices_indirect(
+          buffer->get_handle(), sizeof(vk::DrawIndexedIndirectCommand) * begin,
+          static_cast<uint32_t>(end - begin));
+      m_draw_call_count++;
+    } else {
+      for (size_t i = begin; i < end; i++) {
+        if (m_indirect_first_instance) {
+          render_call.render_indices_indirect(
+              buffer->get_handle(), sizeof(vk::DrawIndexedIndirectCommand) * i,
+              1);
+        } else {
+          const auto &command{m_draws[i].command};
+          render_call.render_indices(command.indexCount, command.firstIndex,
+                                     command.vertexOffset,
+                                     command.firstInstance);
+        }
+      }
+      m_draw_call_count += end - begin;
+    }
+
+    begin = end;
+  }
+}
+
+std::vector<uint16_t> MeshRenderer::_generate_quad_indices() {
+  std::vector<uint16_t> indices;
+  indices.reserve(max_face_count * Block::indices_per_face);
+  for (size_t i = 0; i < max_face_count; i++) {
+    for (const auto index : Block::face_indices) {
+      indices.push_back(
+          static_cast<uint16_t>(i * Block::vertices_per_face + index));
+    }
+  }
+  return indices;
+}
+} // namespace chunk
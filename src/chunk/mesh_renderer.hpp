@@ -0,0 +1,97 @@
+#pragma once
+#include "../core/vulkan/buffer_arena.hpp"
+#include "block.hpp"
+#include <glm/glm.hpp>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace chunk {
+// Collects the draws of all chunk meshes of a frame and renders them with as
+// few draw calls as possible. The draw commands are written into an indirect
+// buffer and every buffer of the mesh arena is drawn with one indirect draw
+// call. The origins of the chunks are stored in the same buffer and read as
+// instance attribute, the firstInstance of a draw selects its origin. All
+// draws share one index buffer since the faces use the same indices
+class MeshRenderer {
+public:
+  // The most faces one draw can have. The LOD tiles have fewer faces than a
+  // section
+  static constexpr size_t max_face_count = Section::max_face_count;
+  MeshRenderer(const ::core::vulkan::Context &context,
+               const ::core::vulkan::BufferArena &arena);
+
+  // Removes the draws of the previous frame
+  void clear();
+  // Adds the origin of a chunk and returns the instance used by its draws
+  inline uint32_t add_instance(const glm::ivec2 &origin) {
+    m_instances.push_back(origin);
+    return static_cast<uint32_t>(m_instances.size() - 1);
+  }
+  // Adds a draw of face_count faces whose vertices are stored at range of the
+  // mesh arena using the origin of instance
+  inline void add_faces(const ::core::vulkan::BufferArena::Range &range,
+                        const uint32_t face_count, const uint32_t instance) {
+    vk::DrawIndexedIndirectCommand command;
+    command.indexCount = face_count * Block::indices_per_face;
+    command.instanceCount = 1;
+    command.firstIndex = 0;
+    command.vertexOffset = static_cast<int32_t>(range.offset / sizeof(Vertex));
+    command.firstInstance = instance;
+    m_draws.push_back(Draw{range.buffer, command});
+  }
+  // Counts a section which has not been drawn since it is outside of the view
+  inline void add_culled() { m_culled_count++; }
+  // Counts a section which has not been drawn since it is hidden behind other
+  // sections
+  inline void add_occluded() { m_occluded_count++; }
+  // Records all added draws into render_call
+  void render(const ::core::vulkan::RenderCall &render_call);
+
+  // Returns how many sections have been drawn in the last frame
+  inline size_t get_draw_count() const { return m_draws.size(); }
+  // Returns how many sections have been culled in the last frame
+  inline size_t get_culled_count() const { return m_culled_count; }
+  // Returns how many sections have been occluded in the last frame
+  inline size_t get_occluded_count() const { return m_occluded_count; }
+  // Returns how many draw calls have been recorded in the last frame
+  inline size_t get_draw_call_count() const { return m_draw_call_count; }
+
+private:
+  // The vertex offset of a draw is added to the indices, so they only need to
+  // address the vertices of one draw
+  static_assert(max_face_count * Block::vertices_per_face <=
+                    std::numeric_limits<uint16_t>::max() + 1,
+                "the vertices of a draw need to be addressable by 16 bit");
+
+  struct Draw {
+    // The buffer of the mesh arena
+    uint32_t buffer;
+    vk::DrawIndexedIndirectCommand command;
+  };
+
+  // Returns the indices of max_face_count faces
+  static std::vector<uint16_t> _generate_quad_indices();
+
+  // The indices of all faces
+  ::core::vulkan::Buffer m_quad_indices;
+  // The draws and instances are written into the buffer of the current swap
+  // chain image. It contains the commands followed by the instances
+  std::vector<std::unique_ptr<::core::vulkan::Buffer>> m_frame_buffers;
+  std::vector<Draw> m_draws;
+  std::vector<glm::ivec2> m_instances;
+  std::vector<uint8_t> m_data;
+  size_t m_culled_count;
+  size_t m_occluded_count;
+  size_t m_draw_call_count;
+
+  // Wether more than one draw can be executed by one indirect draw call
+  const bool m_multi_draw;
+  // Wether indirect draws can use a different first instance than 0. Direct
+  // draw calls are used otherwise
+  const bool m_indirect_first_instance;
+
+  const ::core::vulkan::BufferArena &m_arena;
+  const ::core::vulkan::Context &m_context;
+};
+} // namespace chunk
@@ -0,0 +1,89 @@
+#include "palette_array.hpp"
+
+namespace chunk {
+PaletteArray::PaletteArray(const size_t size, const block::Type value)
+    : m_size(size) {
+  fill(value);
+}
+
+void PaletteArray::set(const size_t index, const block::Type value) {
+  const auto palette_index{_palette_index(value)};
+  // The palette only contains value
+  if (m_bits_per_index == 0) {
+    return;
+  }
+
+  auto &word{m_words[index >> m_entries_per_word_log2]};
+  const auto shift{(index & m_entry_mask) << m_bits_per_index_log2};
+  word = (word & ~(m_index_mask << shift)) | (palette_index << shift);
+}
+
+void PaletteArray::fill(const block::Type value) {
+  m_palette.clear();
+  m_palette.emplace_back(value);
+  m_palette.shrink_to_fit();
+  m_words.clear();
+  m_words.shrink_to_fit();
+  _set_bits_per_index(0);
+}
+
+size_t PaletteArray::memory_usage() const {
+  return sizeof(*this) + m_palette.capacity() * sizeof(block::Type) +
+         m_words.capacity() * sizeof(uint64_t);
+}
+
+uint64_t PaletteArray::_palette_index(const block::Type value) {
+  for (uint64_t i = 0; i < m_palette.size(); i++) {
+    if (m_palette[i] == value) {
+      return i;
+    }
+  }
+
+  m_palette.emplace_back(value);
+  // Only powers of two are used so that no index straddles two words
+  if (m_palette.size() > (static_cast<size_t>(1) << m_bits_per_index)) {
+    _widen(m_bits_per_index == 0 ? 1 : m_bits_per_index * 2);
+  }
+
+  return m_palette.size() - 1;
+}
+
+void PaletteArray::_widen(const uint8_t bits_per_index) {
+  const auto old_words{std::move(m_words)};
+  const auto old_bits_per_index{m_bits_per_index};
+  const auto old_bits_per_index_log2{m_bits_per_index_log2};
+  const auto old_entries_per_word_log2{m_entries_per_word_log2};
+  const auto old_entry_mask{m_entry_mask};
+  const auto old_index_mask{m_index_mask};
+
+  _set_bits_per_index(bits_per_index);
+  m_words.assign((m_size + m_entry_mask) >> m_entries_per_word_log2, 0);
+
+  // Every index has been 0 before
+  if (old_bits_per_index == 0) {
+    return;
+  }
+
+  for (size_t i = 0; i < m_size; i++) {
+    const auto old_shift{(i & old_entry_mask) << old_bits_per_index_log2};
+    const auto palette_index{
+        (old_words[i >> old_entries_per_word_log2] >> old_shift) &
+        old_index_mask};
+
+    const auto shift{(i & m_entry_mask) << m_bits_per_index_log2};
+    m_words[i >> m_entries_per_word_log2] |= palette_index << shift;
+  }
+}
+
+void PaletteArray::_set_bits_per_index(const uint8_t bits_per_index) {
+  m_bits_per_index = bits_per_index;
+  m_bits_per_index_log2 = 0;
+  while ((1 << m_bits_per_index_log2) < m_bits_per_index) {
+    m_bits_per_index_log2++;
+  }
+
+  m_entries_per_word_log2 = bits_per_word_log2 - m_bits_per_index_log2;
+  m_entry_mask = (static_cast<size_t>(1) << m_entries_per_word_log2) - 1;
+  m_index_mask = (static_cast<uint64_t>(1) << m_bits_per_index) - 1;
+}
+} // namespace chunk
@@ -0,0 +1,60 @@
+#pragma once
+#include "../block/type.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace chunk {
+// An array of block types which stores every entry as an index into a palette
+// of all types used in the array. The indices are bit packed into 64 bit words
+// and the amount of bits per index grows automatically when a new type gets
+// added. An array containing only one type uses no words at all.
+// NOTE: set can reallocate the words and the palette. Reading from another
+// thread while setting is not safe
+class PaletteArray {
+public:
+  PaletteArray(const size_t size, const block::Type value = block::Type::AIR);
+
+  inline block::Type get(const size_t index) const {
+    if (m_bits_per_index == 0) {
+      return m_palette.front();
+    }
+
+    const auto word{m_words[index >> m_entries_per_word_log2]};
+    const auto shift{(index & m_entry_mask) << m_bits_per_index_log2};
+    return m_palette[(word >> shift) & m_index_mask];
+  }
+
+  void set(const size_t index, const block::Type value);
+  // Sets every entry to value and shrinks the palette to only contain value
+  void fill(const block::Type value);
+
+  inline size_t size() const { return m_size; }
+  inline size_t get_palette_size() const { return m_palette.size(); }
+  inline uint8_t get_bits_per_index() const { return m_bits_per_index; }
+  // Returns the amount of bytes used by the array including the heap
+  // allocations
+  size_t memory_usage() const;
+
+private:
+  // 64 bits per word
+  static constexpr uint8_t bits_per_word_log2 = 6;
+
+  // Returns the index into the palette of value and adds it to the palette if
+  // it is not yet contained
+  uint64_t _palette_index(const block::Type value);
+  // Repacks all words so that every index uses bits_per_index bits
+  void _widen(const uint8_t bits_per_index);
+  void _set_bits_per_index(const uint8_t bits_per_index);
+
+  std::vector<block::Type> m_palette;
+  std::vector<uint64_t> m_words;
+  size_t m_size;
+
+  uint8_t m_bits_per_index;
+  uint8_t m_bits_per_index_log2;
+  uint8_t m_entries_per_word_log2;
+  size_t m_entry_mask;
+  uint64_t m_index_mask;
+};
+} // namespace chunk
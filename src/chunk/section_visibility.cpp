@@ -0,0 +1,107 @@
+#include "section_visibility.hpp"
+#include <array>
+#include <bitset>
+
+namespace chunk {
+SectionVisibility::SectionVisibility()
+    : m_connections((uint64_t(1) << (face_count * face_count)) - 1) {}
+
+SectionVisibility SectionVisibility::compute(const BlockArray &blocks,
+                                             const size_t section) {
+  const auto &s{blocks.get_section(section)};
+  if (s.is_empty()) {
+    return SectionVisibility();
+  }
+
+  SectionVisibility visibility;
+  visibility.m_connections = 0;
+  if (s.is_full()) {
+    return visibility;
+  }
+
+  constexpr size_t w{block_width}, h{section_height}, d{block_depth};
+  const auto y_offset{section * section_height};
+  const auto index = [](const size_t x, const size_t y, const size_t z) {
+    return x + z * w + y * (w * d);
+  };
+
+  std::bitset<Section::block_count> visited;
+  std::array<uint16_t, Section::block_count> stack;
+
+  // Air regions which do not touch a face of the section can not connect
+  // anything, so only the blocks on the faces are used to start a fill
+  for (size_t y = 0; y < h; y++) {
+    for (size_t z = 0; z < d; z++) {
+      for (size_t x = 0; x < w; x++) {
+        if (!(x == 0 || x == w - 1 || y == 0 || y == h - 1 || z == 0 ||
+              z == d - 1)) {
+          continue;
+        }
+
+        const auto start{index(x, y, z)};
+        if (visited[start] ||
+            blocks.get(x, y + y_offset, z) != block::Type::AIR) {
+          continue;
+        }
+
+        uint8_t faces{0};
+        size_t stack_size{0};
+        stack[stack_size++] = static_cast<uint16_t>(start);
+        visited.set(start);
+
+        while (stack_size != 0) {
+          const size_t i{stack[--stack_size]};
+          const auto bx{i % w}, bz{(i / w) % d}, by{i / (w * d)};
+
+          faces |= (bx == 0) << Block::Face::LEFT;
+          faces |= (bx == w - 1) << Block::Face::RIGHT;
+          faces |= (bz == 0) << Block::Face::BACK;
+          faces |= (bz == d - 1) << Block::Face::FRONT;
+          faces |= (by == 0) << Block::Face::BOT;
+          faces |= (by == h - 1) << Block::Face::TOP;
+
+          const auto visit = [&](const size_t nx, const size_t ny,
+                                 const size_t nz) {
+            const auto n{index(nx, ny, nz)};
+            if (!visited[n] &&
+                blocks.get(nx, ny + y_offset, nz) == block::Type::AIR) {
+              visited.set(n);
+              stack[stack_size++] = static_cast<uint16_t>(n);
+            }
+          };
+
+          if (bx != 0)
+            visit(bx - 1, by, bz);
+          if (bx != w - 1)
+            visit(bx + 1, by, bz);
+          if (by != 0)
+            visit(bx, by - 1, bz);
+          if (by != h - 1)
+            visit(bx, by + 1, bz);
+          if (bz != 0)
+            visit(bx, by, bz - 1);
+          if (bz != d - 1)
+            visit(bx, by, bz + 1);
+        }
+
+        visibility._connect(faces);
+      }
+    }
+  }
+
+  return visibility;
+}
+
+void SectionVisibility::_connect(const uint8_t faces) {
+  for (size_t from = 0; from < face_count; from++) {
+    if (!((faces >> from) & 1)) {
+      continue;
+    }
+    for (size_t to = 0; to < face_count; to++) {
+      if ((faces >> to) & 1) {
+        m_connections |= uint64_t(1) << _bit(from, to);
+      }
+    }
+  }
+}
+} // namespace chunk
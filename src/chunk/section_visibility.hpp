@@ -0,0 +1,47 @@
+#pragma once
+#include "block.hpp"
+#include <cstdint>
+
+namespace chunk {
+// Stores which faces of a section are connected by air inside of the section.
+// Something behind one face can only be seen through another face if they
+// are connected. The faces use the directions of Block::Face
+class SectionVisibility {
+public:
+  static constexpr size_t face_count = 6;
+
+  // All faces are connected which is used for sections that have not been
+  // computed yet
+  SectionVisibility();
+
+  // Flood fills the air of the section of blocks and connects all faces that
+  // are touched by the same air region
+  static SectionVisibility compute(const BlockArray &blocks,
+                                   const size_t section);
+
+  // Returns the face on the opposite side of the section
+  static constexpr Block::Face opposite(const Block::Face face) {
+    return static_cast<Block::Face>(face ^ 1);
+  }
+
+  inline bool can_see(const Block::Face from, const Block::Face to) const {
+    return (m_connections >> _bit(from, to)) & 1;
+  }
+
+private:
+  static_assert(Block::Face::FRONT == 0 && Block::Face::BACK == 1 &&
+                    Block::Face::LEFT == 2 && Block::Face::RIGHT == 3 &&
+                    Block::Face::TOP == 4 && Block::Face::BOT == 5,
+                "opposite faces need to differ only in the lowest bit");
+
+  static constexpr uint64_t _bit(const size_t from, const size_t to) {
+    return from * face_count + to;
+  }
+
+  // Connects every pair of the faces set in faces
+  void _connect(const uint8_t faces);
+
+  // One bit for every pair of faces
+  uint64_t m_connections;
+};
+} // namespace chunk
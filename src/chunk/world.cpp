@@ -2,20 +2,35 @@
 #include "../core/exception.hpp"
 #include "../core/fps_timer.hpp"
 #include "../core/log.hpp"
+#include "../core/profiler.hpp"
+#include <algorithm>
 #include <chrono>
 #include <limits>
+#include <queue>
 #include <set>
 #include <sstream>
 
 namespace chunk {
 World::World(const ::core::vulkan::Context &context,
              const block::Server &block_server)
-    : m_context(context), m_block_server(block_server) {}
+    : m_upload_queue(context),
+      m_mesh_arena(context, m_upload_queue,
+                   vk::BufferUsageFlagBits::eVertexBuffer,
+                   mesh_arena_buffer_size, sizeof(Vertex)),
+      m_mesh_renderer(context, m_mesh_arena),
+      m_lod_terrain(m_mesh_arena, m_job_system, block_server,
+                    m_world_generation),
+      m_mesh_mode(Mesh::Mode::CULLED), m_context(context),
+      m_block_server(block_server) {}
 
 World::~World() {
   m_running = false;
+  _request_update();
   if (m_chunk_update_thread)
     m_chunk_update_thread->join();
+  _wait_for_pending_chunks();
+  // The jobs of the far terrain use the world generation
+  m_lod_terrain.clear();
 
   // Store all chunks
   for (const auto &[chunk_pos, chunk] : m_chunks) {
@@ -43,7 +58,7 @@ void World::set_save_folder(const std::filesystem::path &folder,
 }
 
 void World::place_block(const glm::ivec3 &position, const block::Type block) {
-  std::lock_guard lk(m_chunks_mutex);
+  std::unique_lock lk(m_chunks_mutex);
 
   {
     std::stringstream stream;
@@ -59,6 +74,9 @@ void World::place_block(const glm::ivec3 &position, const block::Type block) {
   }
 
   const auto chunk_pos(get_chunk_position(position));
+  // The palette of a section can be reallocated by set and the light spreads
+  // into the neighbours. So the jobs touching these chunks need to finish
+  _wait_for_jobs_near(lk, {chunk_pos}, block_change_reach);
 
   auto chunk(_get_chunk(chunk_pos));
   if (chunk) {
@@ -68,7 +86,8 @@ void World::place_block(const glm::ivec3 &position, const block::Type block) {
 
     (*chunk)->set(chunk_block_position.x, chunk_block_position.y,
                   chunk_block_position.z, block);
-    (*chunk)->generate_block_change(m_block_server, chunk_block_position);
+    // The affected sections get regenerated in the next call of render
+    (*chunk)->apply_block_change(chunk_block_position);
     return;
   }
 
@@ -82,7 +101,7 @@ void World::place_block(const glm::ivec3 &position, const block::Type block) {
 }
 
 void World::destroy_block(const glm::ivec3 &position) {
-  std::lock_guard lk(m_chunks_mutex);
+  std::unique_lock lk(m_chunks_mutex);
 
   {
     std::stringstream stream;
@@ -93,6 +112,9 @@ void World::destroy_block(const glm::ivec3 &position) {
   }
 
   const auto chunk_pos(get_chunk_position(position));
+  // The palette of a section can be reallocated by set and the light spreads
+  // into the neighbours. So the jobs touching these chunks need to finish
+  _wait_for_jobs_near(lk, {chunk_pos}, block_change_reach);
 
   auto chunk(_get_chunk(chunk_pos));
   if (chunk) {
@@ -102,7 +124,8 @@ void World::destroy_block(const glm::ivec3 &position) {
 
     (*chunk)->set(chunk_block_position.x, chunk_block_position.y,
                   chunk_block_position.z, block::Type::AIR);
-    (*chunk)->generate_block_change(m_block_server, chunk_block_position);
+    // The affected sections get regenerated in the next call of render
+    (*chunk)->apply_block_change(chunk_block_position);
     return;
   }
 
@@ -183,9 +206,22 @@ std::optional<glm::ivec3> World::raycast_block(const physics::Ray &ray,
       // Loop over all blocks of chunk
       for (int x = 0; x < block_width; x++) {
         for (int y = 0; y < block_height; y++) {
+          // Sections which only contain air can't be hit
+          const auto &section{c->get_section_at(y)};
+          if (section.is_empty()) {
+            y += section_height - 1 - y % section_height;
+            continue;
+          }
+
           for (int z = 0; z < block_depth; z++) {
-            const auto &b = c->get_block(x, y, z);
-            if (b.type != block::Type::AIR) {
+            // The inner blocks of a full section are hidden behind its outer
+            // blocks
+            if (section.is_full() && is_inner_section_block(x, y, z)) {
+              continue;
+            }
+
+            if (c->get(x, y, z) != block::Type::AIR) {
+              const auto &b = c->get_block(x, y, z);
               const glm::vec3 block_pos(
                   chunk_world_pos.x + static_cast<float>(x),
                   static_cast<float>(y),
@@ -222,19 +258,150 @@ std::optional<glm::ivec3> World::raycast_block(const physics::Ray &ray,
   return std::nullopt;
 }
 
-void World::render(const ::core::vulkan::RenderCall &render_call) {
+void World::render(const ::core::vulkan::RenderCall &render_call,
+                   const glm::mat4 &proj_view, const glm::vec3 &eye_position) {
   std::lock_guard lk(m_chunks_mutex);
 
   m_chunks_to_delete.clear();
+  m_upload_queue.update();
+  m_mesh_arena.update();
+
+  const physics::Frustum frustum(proj_view);
+  for (auto &[pos, chunk] : m_chunks) {
+    // All block changes since the last frame are regenerated together. The
+    // light of the pending chunks changes the faces of the complete chunks
+    // next to them, so these are regenerated once the pending chunks are done
+    if (chunk->has_changes() &&
+        !_is_pending_job_near(pos, mesh_job_reach + pending_job_reach)) {
+      chunk->generate_changes(m_block_server);
+    }
+    chunk->cull_sections(frustum);
+  }
+  _find_visible_sections(eye_position);
 
+  m_mesh_renderer.clear();
   size_t max_chunk_gen{10};
   for (auto &[pos, chunk] : m_chunks) {
-    chunk->render(render_call, max_chunk_gen);
+    chunk->render(m_mesh_renderer, max_chunk_gen);
+  }
+  m_lod_terrain.update(get_chunk_position(eye_position), m_render_distance);
+  m_lod_terrain.add_draws(m_mesh_renderer, frustum, m_chunks);
+  m_mesh_renderer.render(render_call);
+
+  // The meshes uploaded in this frame are rendered once their copies have
+  // finished. The frame waits for the copies on the GPU so that their data is
+  // visible to the vertex input of this and all later frames
+  if (m_upload_queue.flush(render_call.get_upload_semaphore())) {
+    render_call.wait_for_uploads();
+  }
+}
+
+void World::_find_visible_sections(const glm::vec3 &eye_position) {
+  const auto start_position{get_chunk_position(eye_position)};
+  const auto *start{m_chunks.find(start_position)};
+  if (!start) {
+    for (auto &[pos, chunk] : m_chunks) {
+      chunk->set_frustum_sections_visible();
+    }
+    return;
+  }
+
+  // A camera above or below the world starts at the top or bottom section
+  const auto start_section{std::clamp(
+      static_cast<int>(eye_position.y) / section_height, 0, section_count - 1)};
+
+  m_visibility_queue.clear();
+  (*start)->set_section_visible(start_section);
+  m_visibility_queue.push_back(
+      VisibilityNode{start->get(), start_position, start_section, -1, 0});
+
+  // Breadth first so that every section is entered from the side closest to
+  // the camera
+  for (size_t i = 0; i < m_visibility_queue.size(); i++) {
+    const auto node{m_visibility_queue[i]};
+    const auto &visibility{node.chunk->get_section_visibility(node.section)};
+
+    for (int f = Block::Face::FRONT; f <= Block::Face::BOT; f++) {
+      const auto face{static_cast<Block::Face>(f)};
+      const auto opposite{SectionVisibility::opposite(face)};
+      if ((node.directions >> opposite) & 1) {
+        continue;
+      }
+      if (node.from != -1 &&
+          !visibility.can_see(static_cast<Block::Face>(node.from), face)) {
+        continue;
+      }
+
+      auto position{node.position};
+      auto section{node.section};
+      switch (face) {
+      case Block::Face::FRONT:
+        position.second++;
+        break;
+      case Block::Face::BACK:
+        position.second--;
+        break;
+      case Block::Face::LEFT:
+        position.first--;
+        break;
+      case Block::Face::RIGHT:
+        position.first++;
+        break;
+      case Block::Face::TOP:
+        section++;
+        break;
+      case Block::Face::BOT:
+        section--;
+        break;
+      }
+      if (section < 0 || section >= section_count) {
+        continue;
+      }
+
+      auto *chunk{node.chunk};
+      if (position != node.position) {
+        const auto *neighbour{m_chunks.find(position)};
+        if (!neighbour) {
+          continue;
+        }
+        chunk = neighbour->get();
+      }
+
+      if (!chunk->is_section_in_frustum(section) ||
+          chunk->is_section_visible(section)) {
+        continue;
+      }
+
+      chunk->set_section_visible(section);
+      m_visibility_queue.push_back(VisibilityNode{
+          chunk, position, section, opposite,
+          static_cast<uint8_t>(node.directions | (1 << face))});
+    }
+  }
+}
+
+void World::set_center_position(const glm::vec3 &pos,
+                                const glm::vec3 &look_direction,
+                                const glm::vec3 &velocity) {
+  bool crossed_chunk;
+  {
+    std::lock_guard lk(m_center_position_mutex);
+    crossed_chunk =
+        get_chunk_position(pos) != get_chunk_position(m_center_position);
+    m_center_position = pos;
+    m_look_direction = look_direction;
+    m_velocity = velocity;
+  }
+
+  // Other chunks are inside of the render distance now
+  if (crossed_chunk) {
+    _request_update();
   }
 }
 
 void World::start_update_thread() {
   m_running = true;
+  _request_update();
   m_chunk_update_thread =
       std::make_unique<std::thread>(std::bind(&World::_update, this));
 }
@@ -248,6 +415,8 @@ void World::wait_for_generation(const size_t chunk_count) {
     for (auto &[_, chunk] : m_chunks) {
       chunks_generated += chunk->check_mesh(max_chunk_gen);
     }
+    m_upload_queue.flush();
+    m_upload_queue.update();
     m_chunks_mutex.unlock();
     std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<size_t>(
         1.0f / static_cast<float>(generation_wait_fps) * 1000.0f)));
@@ -263,18 +432,59 @@ std::optional<int> World::get_height(const glm::vec3 &position) {
   const auto pos(get_chunk_position(position));
 
   std::lock_guard lk(m_chunks_mutex);
-  if (m_chunks.find(pos) == m_chunks.end()) {
+  const auto *chunk{m_chunks.find(pos)};
+  if (!chunk) {
     return std::nullopt;
   }
 
-  const auto &chunk = m_chunks.at(pos);
-  return chunk->get_height(position);
+  return (*chunk)->get_height(position);
+}
+
+void World::set_mesh_mode(const Mesh::Mode mode) {
+  std::lock_guard lk(m_chunks_mutex);
+  m_mesh_mode = mode;
+
+  // The jobs of the pending chunks can touch the complete chunks
+  _wait_for_pending_chunks();
+  for (auto &[_, chunk] : m_chunks) {
+    chunk->set_mesh_mode(mode);
+    chunk->generate(m_block_server);
+  }
+
+  // The meshes which are already generated with the old mode are generated
+  // again
+  for (auto &[_, pending] : m_pending_chunks) {
+    pending.chunk->set_mesh_mode(mode);
+    if (pending.stage == MESH) {
+      pending.stage = LIGHT;
+    }
+  }
+  _request_update();
 }
 
 void World::clear_and_reseed() {
   std::lock_guard lk(m_chunks_mutex);
+  // The jobs of the pending chunks use the world generation
+  _wait_for_pending_chunks();
+  m_pending_chunks.clear();
   m_chunks.clear();
+  m_lod_terrain.clear();
   m_world_generation.seed(time(nullptr));
+  _request_update();
+}
+
+float World::_get_load_priority(const std::pair<int, int> &pos,
+                                const glm::vec2 &focus,
+                                const glm::vec2 &forward) {
+  const glm::vec2 offset(static_cast<float>(pos.first) + 0.5f - focus.x,
+                         static_cast<float>(pos.second) + 0.5f - focus.y);
+  const auto distance{glm::length(offset)};
+  if (distance == 0.0f) {
+    return 0.0f;
+  }
+
+  return distance *
+         (1.0f - look_priority_weight * glm::dot(offset / distance, forward));
 }
 
 bool World::_chunks_to_update_contains(
@@ -297,109 +507,313 @@ bool World::_chunks_to_update_contains(
 
 std::optional<std::shared_ptr<Chunk>>
 World::_get_chunk(const std::pair<int, int> &pos) {
-  if (m_chunks.find(pos) == m_chunks.end()) {
-    return std::nullopt;
+  if (auto *chunk{m_chunks.find(pos)}; chunk) {
+    return *chunk;
   }
 
-  return m_chunks[pos];
+  return std::nullopt;
 }
 
 const std::optional<const std::shared_ptr<Chunk>>
 World::_get_chunk(const std::pair<int, int> &pos) const {
-  if (m_chunks.find(pos) == m_chunks.end()) {
-    return std::nullopt;
+  if (const auto *chunk{m_chunks.find(pos)}; chunk) {
+    return *chunk;
   }
 
-  return m_chunks.at(pos);
+  return std::nullopt;
 }
 
-std::shared_ptr<Chunk> World::_check_if_add_neighbour(
-    std::pair<int, int> pos, std::shared_ptr<Chunk> chunk,
-    const std::pair<int, int> &center_position, const int x, const int y) {
-  pos.first += x;
-  pos.second += y;
+std::shared_ptr<Chunk> World::_find_any_chunk(const std::pair<int, int> &pos) {
+  if (auto *chunk{m_chunks.find(pos)}; chunk) {
+    return *chunk;
+  }
+  if (auto pending{m_pending_chunks.find(pos)};
+      pending != m_pending_chunks.end()) {
+    return pending->second.chunk;
+  }
+  return nullptr;
+}
 
-  if (abs(pos.first - center_position.first) > m_render_distance ||
-      abs(pos.second - center_position.second) > m_render_distance) {
-    return nullptr;
+void World::_link_neighbours(const std::pair<int, int> &pos,
+                             const std::shared_ptr<Chunk> &chunk) {
+  if (auto right{_find_any_chunk(std::make_pair(pos.first + 1, pos.second))};
+      right) {
+    chunk->set_right(right);
+    right->set_left(chunk);
+  }
+  if (auto left{_find_any_chunk(std::make_pair(pos.first - 1, pos.second))};
+      left) {
+    chunk->set_left(left);
+    left->set_right(chunk);
+  }
+  if (auto back{_find_any_chunk(std::make_pair(pos.first, pos.second + 1))};
+      back) {
+    chunk->set_back(back);
+    back->set_front(chunk);
   }
+  if (auto front{_find_any_chunk(std::make_pair(pos.first, pos.second - 1))};
+      front) {
+    chunk->set_front(front);
+    front->set_back(chunk);
+  }
+}
 
-  auto new_chunk = std::make_shared<Chunk>(m_context, get_world_position(pos));
+bool World::_is_neighbourhood_ready(const std::pair<int, int> &pos,
+                                    const std::pair<int, int> &center_position,
+                                    const int radius,
+                                    const GenerationStage stage) const {
+  for (int x = pos.first - radius; x <= pos.first + radius; x++) {
+    for (int z = pos.second - radius; z <= pos.second + radius; z++) {
+      if (abs(x - center_position.first) > m_render_distance ||
+          abs(z - center_position.second) > m_render_distance) {
+        continue;
+      }
 
-  // right
-  if (x == 1 && y == 0) {
-    chunk->set_right(new_chunk);
-    new_chunk->set_left(chunk);
-    if (auto front = chunk->get_front(); front) {
-      if (auto right = front->get_right(); right) {
-        right->set_back(new_chunk);
-        new_chunk->set_front(right);
+      const auto pending{m_pending_chunks.find(std::make_pair(x, z))};
+      if (pending == m_pending_chunks.end()) {
+        // The chunk is either complete or has not been created yet
+        if (!m_chunks.contains(std::make_pair(x, z))) {
+          return false;
+        }
+        continue;
       }
-    }
-    if (auto back = chunk->get_back(); back) {
-      if (auto right = back->get_right(); right) {
-        right->set_front(new_chunk);
-        new_chunk->set_back(right);
+      if (pending->second.stage < stage ||
+          (pending->second.stage == stage && !pending->second.done)) {
+        return false;
       }
     }
-    // left
-  } else if (x == -1 && y == 0) {
-    chunk->set_left(new_chunk);
-    new_chunk->set_right(chunk);
-    if (auto front = chunk->get_front(); front) {
-      if (auto left = front->get_left(); left) {
-        left->set_back(new_chunk);
-        new_chunk->set_front(left);
+  }
+  return true;
+}
+
+bool World::_is_stage_running_near(const std::pair<int, int> &pos,
+                                   const int radius,
+                                   const GenerationStage stage) const {
+  for (int x = pos.first - radius; x <= pos.first + radius; x++) {
+    for (int z = pos.second - radius; z <= pos.second + radius; z++) {
+      const auto pending{m_pending_chunks.find(std::make_pair(x, z))};
+      if (pending != m_pending_chunks.end() &&
+          pending->second.stage == stage && !pending->second.done) {
+        return true;
       }
     }
-    if (auto back = chunk->get_back(); back) {
-      if (auto left = back->get_left(); left) {
-        left->set_front(new_chunk);
-        new_chunk->set_back(left);
+  }
+  return false;
+}
+
+bool World::_is_pending_job_near(const std::pair<int, int> &pos,
+                                 const int distance) const {
+  for (int x = pos.first - distance; x <= pos.first + distance; x++) {
+    for (int z = pos.second - distance; z <= pos.second + distance; z++) {
+      const auto pending{m_pending_chunks.find(std::make_pair(x, z))};
+      if (pending != m_pending_chunks.end() && !pending->second.done) {
+        return true;
       }
     }
-    // back
-  } else if (x == 0 && y == 1) {
-    chunk->set_back(new_chunk);
-    new_chunk->set_front(chunk);
-    if (auto right = chunk->get_right(); right) {
-      if (auto back = right->get_back(); back) {
-        back->set_left(new_chunk);
-        new_chunk->set_right(back);
+  }
+  return false;
+}
+
+std::vector<::core::JobSystem::Handle>
+World::_get_pending_jobs_near(const std::pair<int, int> &pos,
+                              const int distance) const {
+  std::vector<::core::JobSystem::Handle> jobs;
+  for (int x = pos.first - distance; x <= pos.first + distance; x++) {
+    for (int z = pos.second - distance; z <= pos.second + distance; z++) {
+      const auto pending{m_pending_chunks.find(std::make_pair(x, z))};
+      if (pending != m_pending_chunks.end() && !pending->second.done) {
+        jobs.emplace_back(pending->second.job);
       }
     }
-    if (auto left = chunk->get_left(); left) {
-      if (auto back = left->get_back(); back) {
-        back->set_right(new_chunk);
-        new_chunk->set_left(back);
+  }
+  return jobs;
+}
+
+std::vector<::core::JobSystem::Handle>
+World::_get_mesh_jobs_near(const std::pair<int, int> &pos,
+                           const int distance) const {
+  std::vector<::core::JobSystem::Handle> jobs;
+  for (int x = pos.first - distance; x <= pos.first + distance; x++) {
+    for (int z = pos.second - distance; z <= pos.second + distance; z++) {
+      if (const auto *chunk{m_chunks.find(std::make_pair(x, z))}; chunk) {
+        if (auto job{(*chunk)->get_generation_job()}; !job.is_done()) {
+          jobs.emplace_back(std::move(job));
+        }
       }
     }
-    // front
-  } else if (x == 0 && y == -1) {
-    chunk->set_front(new_chunk);
-    new_chunk->set_back(chunk);
-    if (auto right = chunk->get_right(); right) {
-      if (auto front = right->get_front(); front) {
-        front->set_left(new_chunk);
-        new_chunk->set_right(front);
-      }
+  }
+  return jobs;
+}
+
+void World::_wait_for_jobs_near(
+    std::unique_lock<std::mutex> &lk,
+    const std::vector<std::pair<int, int>> &positions, const int reach) {
+  // New jobs can be started while m_chunks_mutex is unlocked
+  while (true) {
+    std::vector<::core::JobSystem::Handle> jobs;
+    for (const auto &pos : positions) {
+      const auto pending_jobs{
+          _get_pending_jobs_near(pos, reach + pending_job_reach)};
+      const auto mesh_jobs{_get_mesh_jobs_near(pos, reach + mesh_job_reach)};
+      jobs.insert(jobs.end(), pending_jobs.begin(), pending_jobs.end());
+      jobs.insert(jobs.end(), mesh_jobs.begin(), mesh_jobs.end());
     }
-    if (auto left = chunk->get_left(); left) {
-      if (auto front = left->get_front(); front) {
-        front->set_right(new_chunk);
-        new_chunk->set_left(front);
+    if (jobs.empty()) {
+      return;
+    }
+
+    lk.unlock();
+    ::core::JobSystem::wait_all(jobs);
+    lk.lock();
+  }
+}
+
+std::vector<std::shared_ptr<Chunk>>
+World::_get_neighbourhood(const std::pair<int, int> &pos, const int radius) {
+  std::vector<std::shared_ptr<Chunk>> chunks;
+  for (int x = pos.first - radius; x <= pos.first + radius; x++) {
+    for (int z = pos.second - radius; z <= pos.second + radius; z++) {
+      if (auto chunk{_find_any_chunk(std::make_pair(x, z))}; chunk) {
+        chunks.emplace_back(std::move(chunk));
       }
     }
   }
+  return chunks;
+}
+
+bool World::_start_next_stage(const std::pair<int, int> &pos,
+                              PendingChunk &pending,
+                              const std::pair<int, int> &center_position) {
+  constexpr auto priority{::core::JobSystem::Priority::LOW};
+  auto chunk{pending.chunk};
+  // The mesh jobs of the complete chunks read what the jobs write. No new
+  // ones are started while the job of pending is running
+  const auto get_mesh_jobs{[&]() {
+    return _get_mesh_jobs_near(pos, pending_job_reach + mesh_job_reach);
+  }};
+
+  switch (pending.stage) {
+  case EMPTY:
+    // The save world is only read on the workers. The generated chunks are
+    // stored on the update thread since storing modifies the save world
+    pending.stage = TERRAIN;
+    pending.job = m_job_system.submit(
+        [this, pos, chunk, mesh_jobs = get_mesh_jobs(),
+         &generated = pending.generated]() {
+          VULKANKRAFT_PROFILE_ZONE("World terrain job");
+          ::core::JobSystem::wait_all(mesh_jobs);
+          if (const auto stored_blocks(m_save_world->load_chunk(pos));
+              stored_blocks) {
+            chunk->from_stored_blocks(*stored_blocks);
+          } else {
+            m_world_generation.generate_terrain(chunk->get_position(), *chunk);
+            generated = true;
+          }
+        },
+        priority);
+    return true;
+  case TERRAIN:
+    pending.stage = SURFACE;
+    // The stored blocks already contain the surface. No job wakes up the
+    // update thread, so the surrounding chunks continue in the next update
+    if (!pending.generated) {
+      _request_update();
+      return false;
+    }
+    pending.job = m_job_system.submit(
+        [this, chunk, mesh_jobs = get_mesh_jobs()]() {
+          VULKANKRAFT_PROFILE_ZONE("World surface job");
+          ::core::JobSystem::wait_all(mesh_jobs);
+          m_world_generation.generate_surface(*chunk);
+        },
+        priority);
+    return true;
+  case SURFACE:
+    // The faces on the border depend on the blocks of the neighbours
+    if (!_is_neighbourhood_ready(pos, center_position, 1, SURFACE)) {
+      return false;
+    }
+    pending.stage = FACES;
+    pending.job = m_job_system.submit(
+        [chunk, mesh_jobs = get_mesh_jobs(),
+         neighbourhood = _get_neighbourhood(pos, 1)]() {
+          VULKANKRAFT_PROFILE_ZONE("World faces job");
+          ::core::JobSystem::wait_all(mesh_jobs);
+          chunk->update_faces();
+        },
+        priority);
+    return true;
+  case FACES:
+    // The light reads the blocks of every chunk which lies at most two chunks
+    // away and writes the light and faces of the direct neighbours, which
+    // can still be meshed after the mesh mode has changed
+    if (!_is_neighbourhood_ready(pos, center_position, 2, FACES) ||
+        _is_stage_running_near(pos, 2, LIGHT) ||
+        _is_stage_running_near(pos, 1, MESH)) {
+      return false;
+    }
+    pending.stage = LIGHT;
+    pending.job = m_job_system.submit(
+        [chunk, mesh_jobs = get_mesh_jobs(),
+         neighbourhood = _get_neighbourhood(pos, 2)]() {
+          VULKANKRAFT_PROFILE_ZONE("World light job");
+          ::core::JobSystem::wait_all(mesh_jobs);
+          chunk->compute_light();
+        },
+        priority);
+    return true;
+  case LIGHT:
+    // The faces are final once no chunk can light them anymore
+    if (!_is_neighbourhood_ready(pos, center_position, 2, LIGHT)) {
+      return false;
+    }
+    pending.stage = MESH;
+    // Meshing only reads the chunks, so it can run next to the other mesh
+    // jobs. The sections relit by the surrounding chunks are part of the new
+    // mesh
+    chunk->discard_changes();
+    pending.job =
+        chunk->generate(m_block_server, true, SectionMask().set(), priority);
+    return true;
+  default:
+    return false;
+  }
+}
+
+void World::_wait_for_pending_chunks() {
+  for (const auto &[_, pending] : m_pending_chunks) {
+    pending.job.wait();
+  }
+}
 
-  return new_chunk;
+void World::_request_update() {
+  {
+    std::lock_guard lk(m_update_mutex);
+    m_update_requested = true;
+  }
+  m_update_condition.notify_one();
 }
 
 void World::_update() {
+  VULKANKRAFT_PROFILE_THREAD("update");
   ::core::FPSTimer timer(update_wait_fps);
 
   while (m_running) {
+    // Sleeps until there is something to update instead of polling
+    {
+      std::unique_lock lk(m_update_mutex);
+      m_update_condition.wait(
+          lk, [&] { return m_update_requested || !m_running; });
+      m_update_requested = false;
+    }
+    if (!m_running) {
+      break;
+    }
+
+    // Updates at most update_wait_fps times per second so that the many
+    // finished jobs do not wake it up all the time
     auto delta_timer(timer.begin_frame());
+    VULKANKRAFT_PROFILE_ZONE("World::_update");
 
 #ifndef NDEBUG
     const auto update_start_time = std::chrono::high_resolution_clock::now();
@@ -407,6 +821,9 @@ void World::_update() {
 
     m_center_position_mutex.lock();
     const auto center_position(get_chunk_position(m_center_position));
+    const auto look_direction(m_look_direction);
+    const auto velocity(m_velocity);
+    const auto player_position(m_center_position);
     m_center_position_mutex.unlock();
 
     // First remove all chunks that are too far away
@@ -424,7 +841,7 @@ void World::_update() {
     if (!chunks_to_remove.empty()) {
       std::lock_guard lk(m_chunks_mutex);
       for (const auto &pos : chunks_to_remove) {
-        auto &chunk = m_chunks[pos];
+        const auto chunk{*m_chunks.find(pos)};
 
         auto stored_blocks(chunk->to_stored_blocks());
         m_save_world->store_chunk(pos, stored_blocks);
@@ -438,106 +855,144 @@ void World::_update() {
     size_t chunks_added{0};
 #endif
 
-    std::vector<std::weak_ptr<Chunk>> chunks_to_update;
     {
-      std::lock_guard lk(m_chunks_mutex);
-      if (m_chunks.empty()) {
-#ifndef NDEBUG
-        chunks_added++;
-#endif
-
-        auto chunk = std::make_shared<Chunk>(
-            m_context, get_world_position(center_position));
-        const auto stored_blocks(m_save_world->load_chunk(center_position));
-        if (stored_blocks) {
-          chunk->from_stored_blocks(*stored_blocks);
+      std::unique_lock lk(m_chunks_mutex);
+
+      // Pending chunks which have left the render distance are dropped once
+      // their job has finished
+      for (auto it{m_pending_chunks.begin()}; it != m_pending_chunks.end();) {
+        const auto &[pos, pending] = *it;
+        if ((abs(pos.first - center_position.first) > m_render_distance ||
+             abs(pos.second - center_position.second) > m_render_distance) &&
+            pending.done) {
+          it = m_pending_chunks.erase(it);
         } else {
-          chunk->from_world_generation(m_world_generation);
-          m_save_world->store_chunk(center_position, chunk->to_stored_blocks());
+          ++it;
         }
-
-        m_chunks.emplace(center_position, chunk);
-        chunks_to_update.emplace_back(chunk);
       }
-    }
 
-    // Loop over all chunks and check if neighbors should be added
-    // NOTE: m_chunks is accessed without locking a mutex. This could lead to
-    // race conditions
-    std::vector<std::shared_ptr<Chunk>> chunks_to_add;
-    for (const auto &[pos, chunk] : m_chunks) {
-      if (!chunk->get_right()) {
-        // right
-        chunks_to_add.emplace_back(
-            _check_if_add_neighbour(pos, chunk, center_position, 1, 0));
-      }
-      if (!chunk->get_left()) {
-        // left
-        chunks_to_add.emplace_back(
-            _check_if_add_neighbour(pos, chunk, center_position, -1, 0));
-      }
-      if (!chunk->get_front()) {
-        // front
-        chunks_to_add.emplace_back(
-            _check_if_add_neighbour(pos, chunk, center_position, 0, -1));
+      // Every position inside of the render distance gets a chunk
+      std::vector<std::pair<int, int>> new_positions;
+      for (int x = center_position.first - m_render_distance;
+           x <= center_position.first + m_render_distance; x++) {
+        for (int z = center_position.second - m_render_distance;
+             z <= center_position.second + m_render_distance; z++) {
+          const std::pair pos(x, z);
+          if (!m_chunks.contains(pos) && !m_pending_chunks.count(pos)) {
+            new_positions.emplace_back(pos);
+          }
+        }
       }
-      if (!chunk->get_back()) {
-        // back
-        chunks_to_add.emplace_back(
-            _check_if_add_neighbour(pos, chunk, center_position, 0, 1));
+      if (!new_positions.empty()) {
+        // The jobs read the neighbours of their chunks and linking writes them
+        _wait_for_jobs_near(lk, new_positions, link_reach);
+        for (const auto &pos : new_positions) {
+          auto chunk{std::make_shared<Chunk>(m_mesh_arena, m_job_system,
+                                             get_world_position(pos),
+                                             m_mesh_mode)};
+          _link_neighbours(pos, chunk);
+          m_pending_chunks[pos].chunk = std::move(chunk);
+        }
       }
-    }
 
-    {
-      std::lock_guard lk(m_chunks_mutex);
-      for (auto &chunk : chunks_to_add) {
-        if (!chunk)
+      // Chunks with a generated mesh are complete and get rendered
+      for (auto it{m_pending_chunks.begin()}; it != m_pending_chunks.end();) {
+        const auto &[pos, pending] = *it;
+        if (pending.stage != MESH || !pending.done) {
+          ++it;
           continue;
+        }
 
 #ifndef NDEBUG
         chunks_added++;
 #endif
-
-        const auto chunk_pos(get_chunk_position(chunk->get_position()));
-        const auto stored_blocks(m_save_world->load_chunk(chunk_pos));
-
-        if (stored_blocks) {
-          chunk->from_stored_blocks(*stored_blocks);
-        } else {
-          chunk->from_world_generation(m_world_generation);
-          m_save_world->store_chunk(chunk_pos, chunk->to_stored_blocks());
+        if (pending.generated) {
+          m_save_world->store_chunk(pos, pending.chunk->to_stored_blocks());
         }
+        m_chunks.emplace(pos, pending.chunk);
+        it = m_pending_chunks.erase(it);
+      }
 
-        m_chunks.emplace(get_chunk_position(chunk->get_position()), chunk);
-        chunks_to_update.emplace_back(chunk);
+      // The chunks are prioritized around the position the player is moving
+      // to and towards the look direction, so that the terrain in front of
+      // the player appears first
+      auto lookahead{glm::vec2(velocity.x, velocity.z) * velocity_lookahead /
+                     static_cast<float>(block_width)};
+      if (const auto length{glm::length(lookahead)};
+          length > max_lookahead_distance) {
+        lookahead *= max_lookahead_distance / length;
+      }
+      const auto focus{glm::vec2(player_position.x, player_position.z) /
+                           static_cast<float>(block_width) +
+                       lookahead};
+      auto forward{glm::vec2(look_direction.x, look_direction.z)};
+      if (const auto length{glm::length(forward)}; length != 0.0f) {
+        forward /= length;
       }
-    }
 
-    // Update neighbouring chunks
-    for (auto &_chunk : chunks_to_update) {
-      if (auto chunk = _chunk.lock(); chunk) {
-        chunk->needs_face_update();
-        chunk->compute_sun_light();
-        chunk->generate(m_block_server);
+      // The next stages of the chunks with the highest priority are started
+      // as long as there are free workers
+      using QueuedPosition = std::pair<float, std::pair<int, int>>;
+      size_t running_jobs{0};
+      std::vector<QueuedPosition> waiting_positions;
+      for (const auto &[pos, pending] : m_pending_chunks) {
+        if (!pending.done) {
+          running_jobs++;
+        } else if (pending.stage != MESH) {
+          waiting_positions.emplace_back(
+              _get_load_priority(pos, focus, forward), pos);
+        }
+      }
+      // Only the positions which get a job are taken out of the queue, so
+      // the positions are not sorted completely
+      std::priority_queue<QueuedPosition, std::vector<QueuedPosition>,
+                          std::greater<QueuedPosition>>
+          queue(std::greater<QueuedPosition>(), std::move(waiting_positions));
+
+      const auto max_jobs{m_job_system.get_thread_count() *
+                          pipeline_jobs_per_thread};
+      while (running_jobs < max_jobs && !queue.empty()) {
+        const auto pos{queue.top().second};
+        queue.pop();
+
+        auto &pending{m_pending_chunks.at(pos)};
+        if (!_start_next_stage(pos, pending, center_position)) {
+          continue;
+        }
+        running_jobs++;
+
+        // The finished job can allow the next stages of the surrounding
+        // chunks to start
+        pending.done = false;
+        pending.job = pending.job.then(
+            [this, &done = pending.done] {
+              done = true;
+              _request_update();
+            },
+            ::core::JobSystem::HIGH);
       }
     }
 
 #ifndef NDEBUG
-    if (!(chunks_added == 0 && chunks_to_update.empty() &&
-          chunks_to_remove.empty())) {
+    if (!(chunks_added == 0 && chunks_to_remove.empty())) {
       std::lock_guard lk(m_chunks_mutex);
       const auto gen_end_time = std::chrono::high_resolution_clock::now();
       {
         std::stringstream stream;
         stream << "chunk::World::Update: +" << chunks_added << " -"
-               << chunks_to_remove.size() << " *"
-               << (chunks_to_update.size() - chunks_added) << " ="
-               << m_chunks.size();
+               << chunks_to_remove.size() << " ~" << m_pending_chunks.size()
+               << " =" << m_chunks.size();
         stream << ' '
                << std::chrono::duration_cast<std::chrono::microseconds>(
                       gen_end_time - update_start_time)
                       .count()
                << " µs";
+
+        size_t block_memory{0};
+        for (const auto &[pos, chunk] : m_chunks) {
+          block_memory += chunk->memory_usage();
+        }
+        stream << ' ' << block_memory / 1024 << " KiB";
         ::core::Log::debug(stream.str());
       }
     }
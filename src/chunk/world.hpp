@@ -1,7 +1,11 @@
 #pragma once
+#include "../core/job_system.hpp"
 #include "../physics/ray.hpp"
 #include "../save/world.hpp"
 #include "chunk.hpp"
+#include "chunk_map.hpp"
+#include "lod_terrain.hpp"
+#include <condition_variable>
 #include <map>
 #include <mutex>
 #include <optional>
@@ -36,10 +40,14 @@ public:
                                           physics::Ray::Face &face,
                                           float &distance);
 
-  // Render out the chunks
-  void render(const ::core::vulkan::RenderCall &render_call);
+  // Render out the chunk sections which are inside of the view frustum of
+  // proj_view and can be seen from eye_position
+  void render(const ::core::vulkan::RenderCall &render_call,
+              const glm::mat4 &proj_view, const glm::vec3 &eye_position);
   // Start the background thread which will generate new chunks and destroy
-  // chunks which are too far away
+  // chunks which are too far away. The chunks are generated on the workers of
+  // the job system. The thread sleeps until the player crosses the border of
+  // a chunk or a job of the generation pipeline has finished
   void start_update_thread();
   // Wait until there have been chunk_count chunks generated
   void wait_for_generation(const size_t chunk_count);
@@ -49,30 +57,128 @@ public:
   // Clears all chunks and generates a new world with a different seed. Used for
   // debugging
   void clear_and_reseed();
+  // Changes how the meshes of the chunks are generated and regenerates all
+  // chunks with the new mode
+  void set_mesh_mode(const Mesh::Mode mode);
+  inline Mesh::Mode get_mesh_mode() const { return m_mesh_mode; }
 
-  // Set the position at which the player resides
-  inline void set_center_position(const glm::vec3 &pos) {
-    std::lock_guard lk(m_center_position_mutex);
-    m_center_position = pos;
-  }
+  // Set the position at which the player resides, the direction into which
+  // the player looks and how fast the player moves. The chunks in front of
+  // the player and in the direction of the movement are generated first
+  void set_center_position(const glm::vec3 &pos,
+                           const glm::vec3 &look_direction = glm::vec3(0.0f),
+                           const glm::vec3 &velocity = glm::vec3(0.0f));
 
-  // returns the fog max distance
+  // returns the fog max distance. The fog ends at the end of the far terrain
   inline float set_render_distance(const int render_distance) {
     m_render_distance = render_distance;
-    return static_cast<float>(render_distance) *
+    _request_update();
+    return static_cast<float>(LodTerrain::get_distance(render_distance)) *
            static_cast<float>(block_width);
   }
 
   // Returns the save::World handle used for this world
   inline save::World *get_save_world() { return m_save_world.get(); }
+  // Returns how many sections have been drawn in the last frame and with how
+  // many draw calls
+  inline std::pair<size_t, size_t> get_draw_counts() const {
+    return std::make_pair(m_mesh_renderer.get_draw_count(),
+                          m_mesh_renderer.get_draw_call_count());
+  }
+  // Returns how many sections have been culled by the view frustum in the last
+  // frame
+  inline size_t get_culled_count() const {
+    return m_mesh_renderer.get_culled_count();
+  }
+  // Returns how many sections inside of the view frustum have been hidden
+  // behind other sections in the last frame
+  inline size_t get_occluded_count() const {
+    return m_mesh_renderer.get_occluded_count();
+  }
+  // Returns how many tiles of the far terrain exist
+  inline size_t get_lod_tile_count() const {
+    return m_lod_terrain.get_tile_count();
+  }
+  // Returns how much memory the chunk meshes use on the GPU
+  inline ::core::vulkan::BufferArena::Statistics
+  get_mesh_arena_statistics() const {
+    return m_mesh_arena.get_statistics();
+  }
 
 private:
   // Determines how far away from a ray a block can be in number of blocks
   static constexpr int raycast_distance = 10;
   // Sets the max fps of the backround update thread
   static constexpr size_t update_wait_fps = 100;
+  // Chunks in the look direction of the player count as up to this much closer
+  // and chunks behind the player as this much further away
+  static constexpr float look_priority_weight = 0.5f;
+  // The chunks are prioritized by their distance to where the player will be
+  // after this many seconds, but at most max_lookahead_distance chunks ahead
+  static constexpr float velocity_lookahead = 2.0f;
+  static constexpr float max_lookahead_distance = 2.0f;
   // Sets the wait time for the wait_for_generation method
   static constexpr size_t generation_wait_fps = update_wait_fps / 4;
+  // The size of one buffer of the mesh arena in bytes
+  static constexpr vk::DeviceSize mesh_arena_buffer_size = 64 * 1024 * 1024;
+  // How many jobs of the generation pipeline can run at the same time per
+  // worker of the job system
+  static constexpr size_t pipeline_jobs_per_thread = 2;
+  // How many chunks away from their chunk the jobs and block changes read or
+  // write blocks, faces, light and neighbours. The light of pending chunks
+  // and of block changes spreads into the neighbours and updates the faces on
+  // their borders. Meshing reads the sections of the neighbours and linking a
+  // chunk writes the neighbours of the surrounding chunks
+  static constexpr int pending_job_reach = 2;
+  static constexpr int block_change_reach = 2;
+  static constexpr int mesh_job_reach = 1;
+  static constexpr int link_reach = 1;
+
+  // The stages every new chunk goes through. A stage can only start once the
+  // surrounding chunks have completed the previous stages
+  enum GenerationStage {
+    // The chunk has just been created
+    EMPTY,
+    // The blocks are loaded from the save world or the terrain is generated
+    TERRAIN,
+    // The surface is added to the generated terrain
+    SURFACE,
+    // The visible faces are determined
+    FACES,
+    // The light is computed which also lights the surrounding chunks
+    LIGHT,
+    // The vertices of the mesh are generated. Afterwards the chunk is inserted
+    // into m_chunks
+    MESH,
+  };
+
+  // A chunk which goes through the generation pipeline
+  struct PendingChunk {
+    std::shared_ptr<Chunk> chunk;
+    // The stage which has been started last. It is completed once done is set
+    GenerationStage stage{EMPTY};
+    ::core::JobSystem::Handle job;
+    // Set by job right before it wakes up the update thread. The handle of
+    // job only counts as done after that, so it is not used by the update
+    // thread
+    std::atomic<bool> done{true};
+    // Wether the blocks have been generated instead of loaded. Generated
+    // chunks are stored once they are complete
+    bool generated{false};
+  };
+
+  // A section reached by the search of _find_visible_sections
+  struct VisibilityNode {
+    Chunk *chunk;
+    std::pair<int, int> position;
+    int section;
+    // The face through which the section has been entered or -1 for the
+    // section of the camera
+    int from;
+    // The directions which have been walked to get here as bits of
+    // Block::Face
+    uint8_t directions;
+  };
 
   // Converts a world position into a chunk position which can be used to
   // retrieve chunks from the m_chunks map. Use only one of these methods if you
@@ -101,6 +207,14 @@ private:
     return glm::ivec2(pos.first * block_width, pos.second * block_depth);
   }
 
+  // Returns the priority with which the pending chunk at pos is generated.
+  // Lower values are generated first. It is the distance to focus weighted by
+  // how much the chunk lies in forward. focus is a position in chunks and
+  // forward is a normalized direction or zero
+  static float _get_load_priority(const std::pair<int, int> &pos,
+                                  const glm::vec2 &focus,
+                                  const glm::vec2 &forward);
+
   // Returns wether chunk is contained in chunks_to_update
   // Returns true if chunk is nullptr
   // Returns false if chunks_to_update is empty or holds only nullptr values
@@ -113,39 +227,115 @@ private:
   _get_chunk(const std::pair<int, int> &pos);
   const std::optional<const std::shared_ptr<Chunk>>
   _get_chunk(const std::pair<int, int> &pos) const;
-  // Returns a newly created chunk if it needs to be created
-  // pos .................... the chunk position of the chunk to which should be
-  // a neighbor added. chunk .................. the chunk to which a neighbor
-  // should be added. center_position ........ the position from which world
-  // will be viewed
-  // x,y ...... the relative chunk position to chunk where a new chunk should be
-  // created
-  std::shared_ptr<Chunk>
-  _check_if_add_neighbour(std::pair<int, int> pos, std::shared_ptr<Chunk> chunk,
-                          const std::pair<int, int> &center_position,
-                          const int x, const int y);
+  // Returns the chunk at pos from m_chunks or m_pending_chunks
+  std::shared_ptr<Chunk> _find_any_chunk(const std::pair<int, int> &pos);
+  // Connects chunk with the chunks next to pos
+  void _link_neighbours(const std::pair<int, int> &pos,
+                        const std::shared_ptr<Chunk> &chunk);
+  // Returns wether all chunks at most radius chunks away from pos have
+  // completed stage. Positions outside of the render distance never get a
+  // chunk, so they count as completed
+  bool _is_neighbourhood_ready(const std::pair<int, int> &pos,
+                               const std::pair<int, int> &center_position,
+                               const int radius,
+                               const GenerationStage stage) const;
+  // Returns wether the job of stage is running for a chunk at most radius
+  // chunks away from pos
+  bool _is_stage_running_near(const std::pair<int, int> &pos, const int radius,
+                              const GenerationStage stage) const;
+  // Returns wether a job of a pending chunk is running at most distance chunks
+  // away from pos. Unlike _get_pending_jobs_near it allocates nothing
+  bool _is_pending_job_near(const std::pair<int, int> &pos,
+                            const int distance) const;
+  // Returns the running jobs of the pending chunks which lie at most distance
+  // chunks away from pos
+  std::vector<::core::JobSystem::Handle>
+  _get_pending_jobs_near(const std::pair<int, int> &pos,
+                         const int distance) const;
+  // Returns the running mesh jobs of the complete chunks which lie at most
+  // distance chunks away from pos
+  std::vector<::core::JobSystem::Handle>
+  _get_mesh_jobs_near(const std::pair<int, int> &pos,
+                      const int distance) const;
+  // Waits until no job touches the chunks at most reach chunks away from any
+  // of positions. lk locks m_chunks_mutex and is unlocked while waiting so
+  // that the chunks can be rendered in the meantime. Returns with lk locked
+  void _wait_for_jobs_near(std::unique_lock<std::mutex> &lk,
+                           const std::vector<std::pair<int, int>> &positions,
+                           const int reach);
+  // Returns the chunks at most radius chunks away from pos. They are kept
+  // alive by the jobs which touch them
+  std::vector<std::shared_ptr<Chunk>>
+  _get_neighbourhood(const std::pair<int, int> &pos, const int radius);
+  // Submits the job of the next stage of pending if its surrounding chunks are
+  // ready. Returns wether a job has been submitted
+  bool _start_next_stage(const std::pair<int, int> &pos, PendingChunk &pending,
+                         const std::pair<int, int> &center_position);
+  // Waits for the jobs of all pending chunks
+  void _wait_for_pending_chunks();
+  // Wakes up the background update thread
+  void _request_update();
   // The background update thread function
   void _update();
+  // Marks the sections that can be seen from eye_position. Walks from the
+  // section of the camera through the faces which are connected inside of the
+  // sections. Only sections inside of the frustum are visited and the walk
+  // never turns back towards the camera. All sections inside of the frustum
+  // are marked if the camera is not inside of a chunk
+  void _find_visible_sections(const glm::vec3 &eye_position);
 
+  // Uploads the meshes of the chunks without blocking the rendering
+  ::core::vulkan::UploadQueue m_upload_queue;
+  // Holds the vertices of all chunk meshes. It is declared before
+  // the chunks so that it outlives their meshes
+  ::core::vulkan::BufferArena m_mesh_arena;
+  // Draws the meshes of all chunks
+  MeshRenderer m_mesh_renderer;
+  // Executes the generation, lighting and meshing of the chunks. It is
+  // declared before the chunks so that it outlives all of their jobs
+  ::core::JobSystem m_job_system;
+  // Renders the terrain beyond the chunks
+  LodTerrain m_lod_terrain;
   // Stores all chunks that are currently rendered
-  std::map<std::pair<int, int>, std::shared_ptr<Chunk>> m_chunks;
+  ChunkMap m_chunks;
+  // The chunks inside of the render distance which are still generated.
+  // Guarded by m_chunks_mutex
+  std::map<std::pair<int, int>, PendingChunk> m_pending_chunks;
+  // The queue of _find_visible_sections which is kept to reuse its memory
+  std::vector<VisibilityNode> m_visibility_queue;
   // The background update thread
   std::unique_ptr<std::thread> m_chunk_update_thread;
   // The maximum distance at which chunks are visible in number of chunks
   std::atomic<int> m_render_distance;
   // The position from which the world is viewed
-  glm::vec3 m_center_position;
+  glm::vec3 m_center_position{0.0f};
+  // The direction into which the player looks and how fast the player moves.
+  // Guarded by m_center_position_mutex
+  glm::vec3 m_look_direction{0.0f};
+  glm::vec3 m_velocity{0.0f};
   // If the background update thread should be running
   std::atomic<bool> m_running;
+  // How the meshes of all chunks are generated
+  std::atomic<Mesh::Mode> m_mesh_mode;
   // Stores which chunks should be deleted
   // This vector will be populated by the background update thread and the
   // chunks will be deleted in the main thread
   std::vector<std::shared_ptr<Chunk>> m_chunks_to_delete;
 
-  // A mutex which locks all access directly to the m_chunks map
+  // A mutex which locks all access directly to the m_chunks map. The jobs
+  // of the pending chunks, the mesh jobs of the complete chunks, block
+  // changes and linking new chunks never touch the same chunks at the same
+  // time. All of them are started while this mutex is locked. Block changes
+  // and linking wait for the jobs within their reach and the jobs of the
+  // pending chunks wait for the mesh jobs within their reach
   std::mutex m_chunks_mutex;
   // A mutex which locks all access to m_center_position
   std::mutex m_center_position_mutex;
+  // Wakes up the background update thread. m_update_requested is guarded by
+  // m_update_mutex and is set whenever the chunks need to be updated
+  std::condition_variable m_update_condition;
+  std::mutex m_update_mutex;
+  bool m_update_requested{false};
 
   // Used to generate a procedural terrain
   world_gen::WorldGeneration m_world_generation;
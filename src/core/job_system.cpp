@@ -0,0 +1,236 @@
+#include "job_system.hpp"
+#include "exception.hpp"
+#include "log.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+
+namespace core {
+namespace {
+// The job system and worker index of the calling thread
+thread_local const JobSystem *current_job_system{nullptr};
+thread_local size_t current_worker_index{0};
+} // namespace
+
+JobSystem::Handle::Handle(JobSystem *job_system, std::shared_ptr<State> state)
+    : m_job_system(job_system), m_state(std::move(state)) {}
+
+void JobSystem::Handle::wait() const {
+  if (!m_state) {
+    return;
+  }
+
+  // A worker would block itself and possibly the job it is waiting for
+  if (const auto worker_index{m_job_system->_current_worker_index()};
+      worker_index != m_job_system->get_thread_count()) {
+    while (!is_done()) {
+      if (!m_job_system->_try_run_one(worker_index)) {
+        std::this_thread::yield();
+      }
+    }
+  } else {
+    std::unique_lock lk(m_state->mutex);
+    m_state->finished.wait(lk, [this]() { return m_state->done; });
+  }
+
+  // The exception is never written again once the job is done
+  if (m_state->exception) {
+    std::rethrow_exception(m_state->exception);
+  }
+}
+
+bool JobSystem::Handle::is_done() const {
+  if (!m_state) {
+    return true;
+  }
+
+  std::lock_guard lk(m_state->mutex);
+  return m_state->done;
+}
+
+JobSystem::Handle JobSystem::Handle::then(Job job,
+                                          const Priority priority) const {
+  if (!m_state) {
+    throw VulkanKraftException("tried to chain a job to an empty job handle");
+  }
+
+  Task task{std::move(job), std::make_shared<State>(), priority};
+  Handle handle(m_job_system, task.state);
+
+  {
+    std::lock_guard lk(m_state->mutex);
+    if (!m_state->done) {
+      m_state->continuations.emplace_back(std::move(task));
+      return handle;
+    }
+  }
+
+  m_job_system->_push(std::move(task));
+  return handle;
+}
+
+size_t JobSystem::default_thread_count() {
+  const size_t hardware_threads{std::thread::hardware_concurrency()};
+  return std::max(hardware_threads, static_cast<size_t>(2)) - 1;
+}
+
+void JobSystem::wait_all(const std::vector<Handle> &handles) {
+  // The callers rely on none of the jobs running anymore, even if one of them
+  // has failed
+  std::exception_ptr exception;
+  for (const auto &h : handles) {
+    try {
+      h.wait();
+    } catch (...) {
+      if (!exception) {
+        exception = std::current_exception();
+      }
+    }
+  }
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+JobSystem::JobSystem(const size_t thread_count)
+    : m_next_worker(0), m_queued_jobs(0), m_running(true) {
+  m_workers.reserve(std::max(thread_count, static_cast<size_t>(1)));
+  for (size_t i = 0; i < m_workers.capacity(); i++) {
+    m_workers.emplace_back(std::make_unique<Worker>());
+  }
+  // Start the threads after all workers exist so that they can steal from
+  // every worker
+  for (size_t i = 0; i < m_workers.size(); i++) {
+    m_workers[i]->thread = std::thread(&JobSystem::_worker_main, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard lk(m_sleep_mutex);
+    m_running = false;
+  }
+  m_wake_up.notify_all();
+
+  for (auto &w : m_workers) {
+    w->thread.join();
+  }
+}
+
+JobSystem::Handle JobSystem::submit(Job job, const Priority priority) {
+  Task task{std::move(job), std::make_shared<State>(), priority};
+  Handle handle(this, task.state);
+  _push(std::move(task));
+  return handle;
+}
+
+void JobSystem::_push(Task task) {
+  auto worker_index{_current_worker_index()};
+  if (worker_index == m_workers.size()) {
+    worker_index = m_next_worker++ % m_workers.size();
+  }
+
+  // Count the job before queuing it so that the count never drops below the
+  // amount of queued jobs. The mutex is locked so that no worker misses the
+  // new job between checking for jobs and going to sleep
+  {
+    std::lock_guard lk(m_sleep_mutex);
+    m_queued_jobs++;
+  }
+  {
+    auto &worker{*m_workers[worker_index]};
+    std::lock_guard lk(worker.mutex);
+    worker.queues[task.priority].emplace_back(std::move(task));
+  }
+  m_wake_up.notify_one();
+}
+
+bool JobSystem::_pop(const size_t worker_index, Task &task) {
+  for (size_t p = 0; p < priority_count; p++) {
+    if (worker_index != m_workers.size()) {
+      auto &worker{*m_workers[worker_index]};
+      std::lock_guard lk(worker.mutex);
+      if (auto &queue{worker.queues[p]}; !queue.empty()) {
+        task = std::move(queue.back());
+        queue.pop_back();
+        m_queued_jobs--;
+        return true;
+      }
+    }
+
+    for (size_t i = 1; i <= m_workers.size(); i++) {
+      auto &victim{*m_workers[(worker_index + i) % m_workers.size()]};
+      std::lock_guard lk(victim.mutex);
+      if (auto &queue{victim.queues[p]}; !queue.empty()) {
+        task = std::move(queue.front());
+        queue.pop_front();
+        m_queued_jobs--;
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+bool JobSystem::_try_run_one(const size_t worker_index) {
+  Task task;
+  if (!_pop(worker_index, task)) {
+    return false;
+  }
+
+  _run(task);
+  return true;
+}
+
+void JobSystem::_run(Task &task) {
+  // An exception must not leave the worker. The waiting threads and the
+  // continuations would never be released
+  std::exception_ptr exception;
+  try {
+    task.job();
+  } catch (const std::exception &e) {
+    Log::error(std::string("job failed: ") + e.what());
+    exception = std::current_exception();
+  } catch (...) {
+    Log::error("job failed with an unknown exception");
+    exception = std::current_exception();
+  }
+  // Release everything captured by the job before anyone gets notified
+  task.job = nullptr;
+
+  std::vector<Task> continuations;
+  {
+    std::lock_guard lk(task.state->mutex);
+    task.state->done = true;
+    task.state->exception = std::move(exception);
+    continuations = std::move(task.state->continuations);
+  }
+  task.state->finished.notify_all();
+
+  for (auto &c : continuations) {
+    _push(std::move(c));
+  }
+}
+
+void JobSystem::_worker_main(const size_t worker_index) {
+  current_job_system = this;
+  current_worker_index = worker_index;
+  VULKANKRAFT_PROFILE_THREAD("worker " + std::to_string(worker_index));
+
+  while (true) {
+    if (_try_run_one(worker_index)) {
+      continue;
+    }
+
+    std::unique_lock lk(m_sleep_mutex);
+    m_wake_up.wait(lk, [this]() { return m_queued_jobs != 0 || !m_running; });
+    if (!m_running && m_queued_jobs == 0) {
+      return;
+    }
+  }
+}
+
+size_t JobSystem::_current_worker_index() const {
+  return current_job_system == this ? current_worker_index : m_workers.size();
+}
+} // namespace core
@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace core {
+// A fixed pool of worker threads which execute jobs. Every worker owns a deque
+// of jobs for every priority. A worker takes the newest job of its own deques
+// and steals the oldest job of the other workers if its own deques are empty.
+// Jobs of a higher priority are always taken before jobs of a lower priority
+class JobSystem {
+private:
+  struct State;
+
+public:
+  using Job = std::function<void()>;
+
+  enum Priority {
+    HIGH,
+    NORMAL,
+    LOW,
+  };
+
+  // Refers to a submitted job and is used to wait for it or to chain other
+  // jobs to it. A default constructed handle refers to no job and counts as
+  // done
+  class Handle {
+  public:
+    friend class JobSystem;
+
+    Handle() = default;
+
+    // Blocks until the job has been executed. If it is called from a worker
+    // the worker executes other jobs while waiting. Rethrows the exception
+    // the job has thrown
+    void wait() const;
+    bool is_done() const;
+    // Submits job as soon as this job has been executed
+    Handle then(Job job, const Priority priority = Priority::NORMAL) const;
+
+    inline bool is_valid() const { return static_cast<bool>(m_state); }
+
+  private:
+    Handle(JobSystem *job_system, std::shared_ptr<State> state);
+
+    JobSystem *m_job_system{nullptr};
+    std::shared_ptr<State> m_state;
+  };
+
+  // Returns one thread per hardware thread except for the main thread
+  static size_t default_thread_count();
+  // Waits until all jobs of handles have been executed. Rethrows the first
+  // exception one of the jobs has thrown after all of them are done
+  static void wait_all(const std::vector<Handle> &handles);
+
+  JobSystem(const size_t thread_count = default_thread_count());
+  // Executes all jobs which are still queued and joins the workers
+  ~JobSystem();
+
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  Handle submit(Job job, const Priority priority = Priority::NORMAL);
+
+  inline size_t get_thread_count() const { return m_workers.size(); }
+
+private:
+  static constexpr size_t priority_count = Priority::LOW + 1;
+
+  struct Task {
+    Job job;
+    std::shared_ptr<State> state;
+    Priority priority;
+  };
+
+  struct State {
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done{false};
+    // The exception the job has thrown. The job still counts as done
+    std::exception_ptr exception;
+    // Jobs which get submitted after this job has been executed
+    std::vector<Task> continuations;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::array<std::deque<Task>, priority_count> queues;
+    std::thread thread;
+  };
+
+  // Queues task on the current worker or on the next worker if it is called
+  // from another thread
+  void _push(Task task);
+  // Takes the job with the highest priority from the own deques or steals it
+  // from another worker
+  bool _pop(const size_t worker_index, Task &task);
+  // Executes one job if there is one. Returns wether a job has been executed
+  bool _try_run_one(const size_t worker_index);
+  // Executes the task and submits its continuations even if it throws
+  void _run(Task &task);
+  void _worker_main(const size_t worker_index);
+  // Returns the index of the worker of the calling thread or the amount of
+  // workers if it is not a worker of this job system
+  size_t _current_worker_index() const;
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  // Used to distribute jobs submitted from other threads over the workers
+  std::atomic<size_t> m_next_worker;
+  // The amount of jobs which are queued in any deque
+  std::atomic<size_t> m_queued_jobs;
+  std::atomic<bool> m_running;
+
+  // Used to let the workers sleep while no jobs are queued
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wake_up;
+};
+} // namespace core
@@ -0,0 +1,181 @@
+#include "profiler.hpp"
+#ifdef VULKANKRAFT_PROFILER
+#include "exception.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core {
+namespace {
+// How many zones are stored in one block
+constexpr size_t block_size = 4096;
+// How many full blocks are kept. The oldest blocks are dropped first
+constexpr size_t max_full_blocks = 256;
+
+struct Event {
+  const char *name;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// The zones of one thread. Only the owning thread writes into it. The events
+// before count are never changed again and can be read by every thread
+struct Block {
+  Block(const uint32_t thread) : thread(thread), count(0) {}
+
+  const uint32_t thread;
+  std::atomic<size_t> count;
+  std::array<Event, block_size> events;
+};
+
+struct State {
+  std::mutex mutex;
+  // The blocks which have been filled, the oldest first
+  std::deque<std::unique_ptr<Block>> full_blocks;
+  // The blocks which are currently written by their threads
+  std::vector<Block *> current_blocks;
+  // The name of every thread which has recorded a zone
+  std::vector<std::string> thread_names;
+};
+
+State &get_state() {
+  static State state;
+  return state;
+}
+
+// The buffer of a thread. It is created when the thread records its first zone
+// and hands its last block over to the profiler when the thread exits
+class ThreadBuffer {
+public:
+  ThreadBuffer() {
+    auto &state{get_state()};
+    std::lock_guard lk(state.mutex);
+    m_thread = static_cast<uint32_t>(state.thread_names.size());
+    state.thread_names.emplace_back("thread " + std::to_string(m_thread));
+    m_block = std::make_unique<Block>(m_thread);
+    state.current_blocks.push_back(m_block.get());
+  }
+
+  ~ThreadBuffer() {
+    auto &state{get_state()};
+    std::lock_guard lk(state.mutex);
+    state.current_blocks.erase(std::find(state.current_blocks.begin(),
+                                         state.current_blocks.end(),
+                                         m_block.get()));
+    if (m_block->count != 0) {
+      _hand_over();
+    }
+  }
+
+  inline uint32_t get_thread() const { return m_thread; }
+
+  void record(const Event &event) {
+    auto count{m_block->count.load(std::memory_order_relaxed)};
+    if (count == block_size) {
+      _replace_block();
+      count = 0;
+    }
+
+    m_block->events[count] = event;
+    m_block->count.store(count + 1, std::memory_order_release);
+  }
+
+private:
+  // Moves the full block to the profiler and starts a new one
+  void _replace_block() {
+    auto block{std::make_unique<Block>(m_thread)};
+
+    auto &state{get_state()};
+    std::lock_guard lk(state.mutex);
+    *std::find(state.current_blocks.begin(), state.current_blocks.end(),
+               m_block.get()) = block.get();
+    _hand_over();
+    m_block = std::move(block);
+  }
+
+  // Needs to be called with the mutex of the state locked
+  void _hand_over() {
+    auto &state{get_state()};
+    state.full_blocks.emplace_back(std::move(m_block));
+    if (state.full_blocks.size() > max_full_blocks) {
+      state.full_blocks.pop_front();
+    }
+  }
+
+  uint32_t m_thread;
+  std::unique_ptr<Block> m_block;
+};
+
+thread_local ThreadBuffer thread_buffer;
+} // namespace
+
+void Profiler::set_thread_name(const std::string &name) {
+  const auto thread{thread_buffer.get_thread()};
+
+  auto &state{get_state()};
+  std::lock_guard lk(state.mutex);
+  state.thread_names[thread] = name;
+}
+
+void Profiler::export_trace(const std::filesystem::path &file_name) {
+  std::ofstream file(file_name);
+  if (file.fail()) {
+    throw VulkanKraftException("failed to open profiler trace file \"" +
+                               file_name.string() + "\"");
+  }
+
+  auto &state{get_state()};
+  std::lock_guard lk(state.mutex);
+
+  file << "{\"traceEvents\":[";
+  for (size_t i = 0; i < state.thread_names.size(); i++) {
+    file << (i == 0 ? "" : ",")
+         << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+         << ",\"args\":{\"name\":\"" << state.thread_names[i] << "\"}}";
+  }
+
+  std::vector<const Block *> blocks;
+  for (const auto &block : state.full_blocks) {
+    blocks.push_back(block.get());
+  }
+  blocks.insert(blocks.end(), state.current_blocks.begin(),
+                state.current_blocks.end());
+
+  // The times are written in microseconds relative to the earliest zone
+  auto start{std::numeric_limits<uint64_t>::max()};
+  for (const auto *block : blocks) {
+    const auto count{block->count.load(std::memory_order_acquire)};
+    for (size_t i = 0; i < count; i++) {
+      start = std::min(start, block->events[i].begin);
+    }
+  }
+
+  file << std::fixed << std::setprecision(3);
+  for (const auto *block : blocks) {
+    const auto count{block->count.load(std::memory_order_acquire)};
+    for (size_t i = 0; i < count; i++) {
+      const auto &event{block->events[i]};
+      file << ",\n{\"name\":\"" << event.name
+           << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << block->thread
+           << ",\"ts\":" << static_cast<double>(event.begin - start) * 1e-3
+           << ",\"dur\":" << static_cast<double>(event.end - event.begin) * 1e-3
+           << '}';
+    }
+  }
+
+  file << "\n]}\n";
+}
+
+void Profiler::_record(const char *name, const uint64_t begin,
+                       const uint64_t end) {
+  thread_buffer.record(Event{name, begin, end});
+}
+} // namespace core
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+
+// The profiler is only compiled in if VULKANKRAFT_PROFILER is defined. The
+// macros expand to nothing otherwise
+#ifdef VULKANKRAFT_PROFILER
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#define VULKANKRAFT_PROFILE_CONCAT_(a, b) a##b
+#define VULKANKRAFT_PROFILE_CONCAT(a, b) VULKANKRAFT_PROFILE_CONCAT_(a, b)
+// Measures the time until the end of the current scope. name needs to be a
+// string literal
+#define VULKANKRAFT_PROFILE_ZONE(name)                                        \
+  const ::core::Profiler::Zone VULKANKRAFT_PROFILE_CONCAT(profile_zone_,      \
+                                                          __LINE__)(name)
+// Sets the name under which the zones of the calling thread are shown
+#define VULKANKRAFT_PROFILE_THREAD(name) ::core::Profiler::set_thread_name(name)
+
+namespace core {
+// Records the begin and end of zones of all threads. Every thread writes into
+// its own buffer without locking. Only full buffers are handed over to the
+// profiler with a lock. The recorded zones can be exported as Chrome
+// trace_event JSON which can be opened with chrome://tracing or Perfetto
+class Profiler {
+public:
+  // Records the time from its construction to its destruction
+  class Zone {
+  public:
+    inline Zone(const char *name) : m_name(name), m_begin(_now()) {}
+    inline ~Zone() { _record(m_name, m_begin, _now()); }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+
+  private:
+    const char *m_name;
+    const uint64_t m_begin;
+  };
+
+  // Sets the name of the calling thread in the exported trace
+  static void set_thread_name(const std::string &name);
+  // Writes the recorded zones into file_name. The oldest zones are dropped
+  // once too many have been recorded
+  static void export_trace(const std::filesystem::path &file_name);
+
+private:
+  // Returns the current time in nanoseconds
+  static inline uint64_t _now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+
+  // Adds a zone to the buffer of the calling thread
+  static void _record(const char *name, const uint64_t begin,
+                      const uint64_t end);
+};
+} // namespace core
+#else
+#define VULKANKRAFT_PROFILE_ZONE(name)
+#define VULKANKRAFT_PROFILE_THREAD(name)
+#endif
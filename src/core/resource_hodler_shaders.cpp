@@ -20,13 +20,14 @@ void ResourceHodler::build_chunk_mesh_shader(const vulkan::Context &context,
   global.proj_view = glm::mat4(1.0f);
 
   auto shader(::core::Shader::Builder()
-                  .vertex_attribute<glm::vec3>()
-                  .vertex_attribute<glm::vec2>()
-                  .vertex_attribute<glm::f32>()
+                  .vertex_attribute<glm::uvec2>()
+                  // chunk origin
+                  .instance_attribute<glm::ivec2>()
                   .vertex(shaders::chunk_mesh_vert_spv)
                   .fragment(shaders::chunk_mesh_frag_spv)
                   .uniform_buffer(vk::ShaderStageFlagBits::eVertex, global)
                   .texture()
+                  // fog max distance
                   .push_constant<float>(vk::ShaderStageFlagBits::eFragment)
                   .build(context, settings));
   shader.set_texture(get_texture(chunk_mesh_texture_name));
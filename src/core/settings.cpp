@@ -14,7 +14,8 @@ namespace core {
 Settings::Settings()
     : msaa_samples(vk::SampleCountFlagBits::e4), max_fps(60),
       window_width(1280), window_height(720),
-      field_of_view(glm::radians(70.0f)), render_distance(6) {
+      field_of_view(glm::radians(70.0f)), render_distance(6),
+      greedy_meshing(false), gpu_profiling(false) {
   // handle settings folder
 #ifdef _WIN32
   const char *appdata = getenv("APPDATA");
@@ -68,6 +69,14 @@ Settings::Settings()
           render_distance =
               json_file[render_distance_key].get<decltype(render_distance)>();
         }
+        if (json_file.contains(greedy_meshing_key)) {
+          greedy_meshing =
+              json_file[greedy_meshing_key].get<decltype(greedy_meshing)>();
+        }
+        if (json_file.contains(gpu_profiling_key)) {
+          gpu_profiling =
+              json_file[gpu_profiling_key].get<decltype(gpu_profiling)>();
+        }
 
         Log::info("Successfully read " + settings_file.string());
       } catch (const json::exception &e) {
@@ -127,7 +136,9 @@ void Settings::write_settings_file() const {
                   {window_width_key, window_width},
                   {window_height_key, window_height},
                   {field_of_view_key, glm::degrees(field_of_view)},
-                  {render_distance_key, render_distance}});
+                  {render_distance_key, render_distance},
+                  {greedy_meshing_key, greedy_meshing},
+                  {gpu_profiling_key, gpu_profiling}});
 
     Log::info("Successfully wrote to " + settings_file.string());
   } catch (const json::exception &e) {
@@ -35,6 +35,13 @@ public:
   float field_of_view;
   // Defines how far the player will be able to see in chunks
   int render_distance;
+  // Wether coplanar faces of the chunk meshes should be merged into larger
+  // quads
+  bool greedy_meshing;
+  // Wether the GPU time of the render passes is measured with timestamp
+  // queries. The timings are shown in the debug overlay and written into a CSV
+  // file in the settings folder
+  bool gpu_profiling;
 
   void write_settings_file() const;
   inline std::filesystem::path get_controller_db_file_name() const {
@@ -52,6 +59,8 @@ private:
   static constexpr char window_height_key[] = "height";
   static constexpr char field_of_view_key[] = "fov";
   static constexpr char render_distance_key[] = "render_distance";
+  static constexpr char greedy_meshing_key[] = "greedy_meshing";
+  static constexpr char gpu_profiling_key[] = "gpu_profiling";
 
   // Downloads the sdl controller db file from the master branch of
   // https://github.com/gabomdq/SDL_GameControllerDB
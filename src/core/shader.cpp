@@ -209,24 +209,33 @@ void Shader::_create_graphics_pipeline(const vulkan::Context &context,
     }
   }
 
-  vk::VertexInputBindingDescription bind;
-  bind.binding = 0;
-  for (const auto &vi : builder.m_vertex_attributes) {
-    bind.stride += static_cast<uint32_t>(vi.size);
-  }
-  bind.inputRate = vk::VertexInputRate::eVertex;
-
-  std::vector<vk::VertexInputAttributeDescription> atts(
-      builder.m_vertex_attributes.size());
-  for (size_t i = 0; i < atts.size(); i++) {
-    atts[i].binding = 0;
-    atts[i].location = static_cast<uint32_t>(i);
-    atts[i].format = builder.m_vertex_attributes[i].format;
-    atts[i].offset =
-        i == 0
-            ? 0
-            : (atts[i - 1].offset +
-               static_cast<uint32_t>(builder.m_vertex_attributes[i - 1].size));
+  // The vertex attributes are read from binding 0 and the instance
+  // attributes from binding 1
+  std::vector<vk::VertexInputBindingDescription> binds;
+  std::vector<vk::VertexInputAttributeDescription> atts;
+  for (const auto &[attributes, input_rate] :
+       {std::make_pair(&builder.m_vertex_attributes,
+                       vk::VertexInputRate::eVertex),
+        std::make_pair(&builder.m_instance_attributes,
+                       vk::VertexInputRate::eInstance)}) {
+    if (attributes->empty()) {
+      continue;
+    }
+
+    vk::VertexInputBindingDescription bind;
+    bind.binding = static_cast<uint32_t>(binds.size());
+    bind.inputRate = input_rate;
+
+    for (const auto &vi : *attributes) {
+      auto &att = atts.emplace_back();
+      att.binding = bind.binding;
+      att.location = static_cast<uint32_t>(atts.size() - 1);
+      att.format = vi.format;
+      att.offset = bind.stride;
+      bind.stride += static_cast<uint32_t>(vi.size);
+    }
+
+    binds.emplace_back(std::move(bind));
   }
 
   std::vector<vk::DescriptorSetLayout> all_layouts;
@@ -240,7 +249,7 @@ void Shader::_create_graphics_pipeline(const vulkan::Context &context,
   try {
     m_pipeline = std::make_unique<vulkan::GraphicsPipeline>(
         context, std::move(all_layouts), std::move(builder.m_vertex_code),
-        std::move(builder.m_fragment_code), std::move(bind), std::move(atts),
+        std::move(builder.m_fragment_code), std::move(binds), std::move(atts),
         settings.msaa_samples, builder.m_alpha_blending,
         builder.m_push_constants, builder.m_primitive_topology);
   } catch (const VulkanKraftException &e) {
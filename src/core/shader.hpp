@@ -59,6 +59,14 @@ public:
           VertexAttributeInfo{vulkan::vertex_attribute_format<T>, sizeof(T)});
       return *this;
     }
+    // Add an attribute of the given type T which is read once per instance
+    // from the vertex buffer bound to binding 1. Its location follows the
+    // locations of the vertex attributes
+    template <typename T> inline Builder &instance_attribute() {
+      m_instance_attributes.emplace_back(
+          VertexAttributeInfo{vulkan::vertex_attribute_format<T>, sizeof(T)});
+      return *this;
+    }
 
     // Add a static texture (A texture which is the same during one render call)
     inline Builder &texture() {
@@ -120,6 +128,7 @@ public:
     vulkan::SPVData m_fragment_code;
     std::vector<UniformBufferInfo> m_uniform_buffers;
     std::vector<VertexAttributeInfo> m_vertex_attributes;
+    std::vector<VertexAttributeInfo> m_instance_attributes;
     size_t m_texture_count;
     std::vector<uint32_t> m_dynamic_textures;
     bool m_alpha_blending;
@@ -1,12 +1,14 @@
 #include "buffer.hpp"
 #include "../exception.hpp"
+#include "../profiler.hpp"
+#include <array>
 #include <cstring>
 
 namespace core {
 namespace vulkan {
 Buffer::Buffer(const Context &context, vk::BufferUsageFlags usage,
                const size_t buffer_size, const void *data)
-    : m_usage(usage | ((usage & vk::BufferUsageFlagBits::eUniformBuffer)
+    : m_usage(usage | (_is_host_visible(usage)
                            ? static_cast<vk::BufferUsageFlagBits>(0)
                            : vk::BufferUsageFlagBits::eTransferDst)),
       m_context(context) {
@@ -30,16 +32,23 @@ Buffer::~Buffer() { _destroy(); }
 
 void Buffer::set_data(const void *data, const size_t data_size,
                       const size_t offset) {
+  VULKANKRAFT_PROFILE_ZONE("Buffer::set_data");
   if (data_size != m_buffer_size) {
     _destroy();
     _create(data_size);
   }
 
-  if (m_usage & vk::BufferUsageFlagBits::eUniformBuffer) {
+  write(data, data_size, offset);
+}
+
+void Buffer::write(const void *data, const size_t data_size,
+                   const size_t offset) {
+  if (_is_host_visible(m_usage)) {
     // memcpy data directly to buffer
     try {
       void *mapped_data = m_context.get_device().mapMemory(
-          m_memory, 0, static_cast<vk::DeviceSize>(data_size));
+          m_memory, static_cast<vk::DeviceSize>(offset),
+          static_cast<vk::DeviceSize>(data_size));
       memcpy(mapped_data, data, data_size);
       m_context.get_device().unmapMemory(m_memory);
     } catch (const std::runtime_error &e) {
@@ -119,6 +128,22 @@ void Buffer::_create(const vk::DeviceSize buffer_size) {
   bi.usage = m_usage;
   bi.sharingMode = vk::SharingMode::eExclusive;
 
+  // Device local buffers can be written by the transfer queue. Sharing them
+  // avoids transferring the ownership between the queue families. Concurrent
+  // buffers can be accessed by both families without a release and an acquire
+  // barrier, which would need to be recorded on both queues for every copy.
+  // Only the semaphore of the uploads is needed to make the copies visible
+  const std::array<uint32_t, 2> queue_families{
+      m_context.get_physical_device_info()
+          .queue_family_indices.graphics_family.value(),
+      m_context.get_transfer_queue_family()};
+  if (!_is_host_visible(m_usage) &&
+      m_context.has_dedicated_transfer_queue()) {
+    bi.sharingMode = vk::SharingMode::eConcurrent;
+    bi.queueFamilyIndexCount = static_cast<uint32_t>(queue_families.size());
+    bi.pQueueFamilyIndices = queue_families.data();
+  }
+
   try {
     m_handle = m_context.get_device().createBuffer(bi);
   } catch (const std::runtime_error &e) {
@@ -132,7 +157,7 @@ void Buffer::_create(const vk::DeviceSize buffer_size) {
   ai.allocationSize = mem_req.size;
   ai.memoryTypeIndex = m_context.find_memory_type(
       mem_req.memoryTypeBits,
-      (m_usage & vk::BufferUsageFlagBits::eUniformBuffer)
+      _is_host_visible(m_usage)
           ? (vk::MemoryPropertyFlagBits::eHostVisible |
              vk::MemoryPropertyFlagBits::eHostCoherent)
           : vk::MemoryPropertyFlagBits::eDeviceLocal);
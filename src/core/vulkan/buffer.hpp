@@ -16,11 +16,24 @@ public:
   // Update the data of the buffer. Recreate it if the size changed
   void set_data(const void *data, const size_t data_size,
                 const size_t offset = 0);
+  // Writes data at offset into the buffer without recreating it. The buffer
+  // needs to be large enough
+  void write(const void *data, const size_t data_size,
+             const size_t offset = 0);
   // Bind the buffer depending on the usage
   void bind(const RenderCall &render_call) const;
   inline const vk::Buffer &get_handle() const { return m_handle; }
+  inline vk::DeviceSize get_size() const { return m_buffer_size; }
 
 private:
+  // Buffers which are rewritten every frame are stored in host visible memory
+  // and written directly instead of through a staging buffer
+  static inline bool _is_host_visible(const vk::BufferUsageFlags usage) {
+    return static_cast<bool>(usage &
+                             (vk::BufferUsageFlagBits::eUniformBuffer |
+                              vk::BufferUsageFlagBits::eIndirectBuffer));
+  }
+
   void _create(const vk::DeviceSize buffer_size);
   void _destroy();
 
@@ -0,0 +1,283 @@
+#include "buffer_arena.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace core {
+namespace vulkan {
+BufferArena::BufferArena(const Context &context, UploadQueue &upload_queue,
+                         const vk::BufferUsageFlags usage,
+                         const vk::DeviceSize buffer_size,
+                         const vk::DeviceSize alignment)
+    : m_frame(0),
+      // The allocations are copied from one buffer to another by _compact
+      m_usage(usage | vk::BufferUsageFlagBits::eTransferSrc),
+      m_buffer_size(buffer_size), m_alignment(alignment), m_context(context),
+      m_upload_queue(upload_queue) {}
+
+BufferArena::Handle BufferArena::allocate(const void *data,
+                                          const vk::DeviceSize size) {
+  if (size == 0) {
+    return invalid_handle;
+  }
+
+  const auto aligned_size{_align(size)};
+  constexpr auto end_offset{std::numeric_limits<vk::DeviceSize>::max()};
+
+  auto range{m_buffers.empty()
+                 ? Range{0, 0, 0}
+                 : _take_free_range(aligned_size,
+                                    static_cast<uint32_t>(m_buffers.size() - 1),
+                                    end_offset)};
+  if (range.size == 0) {
+    range = _take_free_range(aligned_size, _create_buffer(aligned_size),
+                             end_offset);
+  }
+
+  auto &buffer{m_buffers[range.buffer]};
+  const Allocation allocation{
+      range, Range{0, 0, 0},
+      m_upload_queue.upload(*buffer.buffer, range.offset, data, size)};
+
+  Handle handle;
+  if (!m_free_handles.empty()) {
+    handle = m_free_handles.back();
+    m_free_handles.pop_back();
+    m_allocations[handle] = allocation;
+  } else {
+    handle = static_cast<Handle>(m_allocations.size());
+    m_allocations.push_back(allocation);
+  }
+  buffer.allocations.emplace(range.offset, handle);
+
+  return handle;
+}
+
+void BufferArena::free(const Handle handle) {
+  if (handle == invalid_handle) {
+    return;
+  }
+
+  std::lock_guard lk(m_freed_handles_mutex);
+  m_freed_handles.push_back(handle);
+}
+
+void BufferArena::update(const vk::DeviceSize max_compaction_bytes) {
+  m_frame++;
+
+  {
+    std::lock_guard lk(m_freed_handles_mutex);
+    for (const auto handle : m_freed_handles) {
+      const auto &allocation{m_allocations[handle]};
+      m_pending_frees.push_back(
+          PendingFree{allocation.range, m_frame, allocation.upload});
+
+      // The range of a moved allocation has already been removed from the
+      // allocations of its buffer when the move started
+      if (const auto &moved{allocation.moved_range}; moved.size != 0) {
+        m_buffers[moved.buffer].allocations.erase(moved.offset);
+        m_pending_frees.push_back(
+            PendingFree{moved, m_frame, allocation.upload});
+        m_moving_handles.erase(std::find(m_moving_handles.begin(),
+                                         m_moving_handles.end(), handle));
+      } else {
+        m_buffers[allocation.range.buffer].allocations.erase(
+            allocation.range.offset);
+      }
+
+      m_free_handles.push_back(handle);
+    }
+    m_freed_handles.clear();
+  }
+
+  _finish_moves();
+
+  // Release the ranges which are neither used by any frame in flight nor
+  // written by a copy anymore
+  const auto released{std::partition(
+      m_pending_frees.begin(), m_pending_frees.end(),
+      [&](const PendingFree &pending) {
+        return m_frame - pending.frame < release_delay ||
+               !m_upload_queue.is_complete(pending.upload);
+      })};
+  for (auto it = released; it != m_pending_frees.end(); it++) {
+    _add_free_range(it->range);
+  }
+  m_pending_frees.erase(released, m_pending_frees.end());
+
+  // Destroy the buffers which are completely free. The first buffer is kept
+  // since it would be created again with the next allocation
+  for (size_t i = 1; i < m_buffers.size(); i++) {
+    auto &buffer{m_buffers[i]};
+    if (buffer.buffer && buffer.allocations.empty() &&
+        buffer.free_ranges.size() == 1 &&
+        buffer.free_ranges.begin()->second == buffer.buffer->get_size()) {
+      buffer.buffer.reset();
+      buffer.free_ranges.clear();
+    }
+  }
+
+  if (get_statistics().fragmentation > compaction_threshold) {
+    _compact(max_compaction_bytes);
+  }
+}
+
+BufferArena::Statistics BufferArena::get_statistics() const {
+  Statistics stats;
+  vk::DeviceSize free_size{0};
+
+  for (const auto &buffer : m_buffers) {
+    if (!buffer.buffer) {
+      continue;
+    }
+
+    stats.buffer_count++;
+    stats.allocation_count += buffer.allocations.size();
+    stats.free_range_count += buffer.free_ranges.size();
+    stats.capacity += buffer.buffer->get_size();
+    for (const auto &[offset, size] : buffer.free_ranges) {
+      free_size += size;
+      stats.largest_free_range = std::max(stats.largest_free_range, size);
+    }
+  }
+
+  // The pending ranges are neither used nor free yet
+  vk::DeviceSize pending_size{0};
+  for (const auto &pending : m_pending_frees) {
+    pending_size += pending.range.size;
+  }
+
+  stats.used = stats.capacity - free_size - pending_size;
+  if (free_size != 0) {
+    stats.fragmentation =
+        1.0f - static_cast<float>(stats.largest_free_range) /
+                   static_cast<float>(free_size);
+  }
+
+  return stats;
+}
+
+BufferArena::Range
+BufferArena::_take_free_range(const vk::DeviceSize size,
+                              const uint32_t last_buffer,
+                              const vk::DeviceSize end_offset) {
+  for (uint32_t i = 0; i <= last_buffer && i < m_buffers.size(); i++) {
+    auto &free_ranges{m_buffers[i].free_ranges};
+    for (auto it = free_ranges.begin(); it != free_ranges.end(); it++) {
+      const auto [offset, free_size] = *it;
+      if (i == last_buffer && offset + size > end_offset) {
+        break;
+      }
+      if (free_size < size) {
+        continue;
+      }
+
+      free_ranges.erase(it);
+      if (free_size > size) {
+        free_ranges.emplace(offset + size, free_size - size);
+      }
+      return Range{i, offset, size};
+    }
+  }
+
+  return Range{0, 0, 0};
+}
+
+void BufferArena::_add_free_range(const Range &range) {
+  auto &free_ranges{m_buffers[range.buffer].free_ranges};
+  auto offset{range.offset};
+  auto size{range.size};
+
+  // Merge with the free range directly after
+  if (const auto next{free_ranges.find(offset + size)};
+      next != free_ranges.end()) {
+    size += next->second;
+    free_ranges.erase(next);
+  }
+
+  // Merge with the free range directly before
+  if (auto next{free_ranges.lower_bound(offset)};
+      next != free_ranges.begin()) {
+    if (const auto prev{std::prev(next)};
+        prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      free_ranges.erase(prev);
+    }
+  }
+
+  free_ranges.emplace(offset, size);
+}
+
+uint32_t BufferArena::_create_buffer(const vk::DeviceSize size) {
+  const auto buffer_size{std::max(m_buffer_size, size)};
+
+  // Reuse the slot of a destroyed buffer so that the indices stay small
+  auto slot{std::find_if(
+      m_buffers.begin(), m_buffers.end(),
+      [](const ArenaBuffer &buffer) { return !buffer.buffer; })};
+  if (slot == m_buffers.end()) {
+    slot = m_buffers.emplace(m_buffers.end());
+  }
+
+  slot->buffer = std::make_unique<Buffer>(m_context, m_usage, buffer_size);
+  slot->free_ranges.emplace(0, buffer_size);
+
+  return static_cast<uint32_t>(slot - m_buffers.begin());
+}
+
+void BufferArena::_compact(vk::DeviceSize max_bytes) {
+  // Move the allocations at the very end into the first free range which lies
+  // before them until no such range exists anymore
+  for (auto i = static_cast<uint32_t>(m_buffers.size());
+       i-- > 0 && max_bytes != 0;) {
+    auto &buffer{m_buffers[i]};
+    while (!buffer.allocations.empty() && max_bytes != 0) {
+      const auto last{std::prev(buffer.allocations.end())};
+      const auto handle{last->second};
+      auto &allocation{m_allocations[handle]};
+
+      // Allocations whose data is still being written can not be moved
+      if (allocation.moved_range.size != 0 ||
+          !m_upload_queue.is_complete(allocation.upload)) {
+        break;
+      }
+
+      const auto &from{allocation.range};
+      const auto to{_take_free_range(from.size, i, from.offset)};
+      if (to.size == 0) {
+        break;
+      }
+
+      // The allocation is rendered from its old range until the copy has
+      // finished
+      buffer.allocations.erase(last);
+      m_buffers[to.buffer].allocations.emplace(to.offset, handle);
+      allocation.moved_range = to;
+      allocation.upload = m_upload_queue.copy(
+          *buffer.buffer, from.offset, *m_buffers[to.buffer].buffer, to.offset,
+          from.size);
+      m_moving_handles.push_back(handle);
+
+      max_bytes -= std::min(max_bytes, from.size);
+    }
+  }
+}
+
+void BufferArena::_finish_moves() {
+  const auto finished{std::partition(
+      m_moving_handles.begin(), m_moving_handles.end(), [&](const Handle h) {
+        return !m_upload_queue.is_complete(m_allocations[h].upload);
+      })};
+
+  for (auto it = finished; it != m_moving_handles.end(); it++) {
+    auto &allocation{m_allocations[*it]};
+    // The old range can still be used by the frames in flight
+    m_pending_frees.push_back(
+        PendingFree{allocation.range, m_frame, allocation.upload});
+    allocation.range = allocation.moved_range;
+    allocation.moved_range = Range{0, 0, 0};
+  }
+  m_moving_handles.erase(finished, m_moving_handles.end());
+}
+} // namespace vulkan
+} // namespace core
@@ -0,0 +1,170 @@
+#pragma once
+#include "upload_queue.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace core {
+namespace vulkan {
+// Sub-allocates ranges of a few large device local buffers instead of
+// allocating memory for every single buffer. The free ranges of every buffer
+// are kept in a free list sorted by their offset so that neighbouring free
+// ranges get merged. A freed range is only reused after all frames which
+// could still be using it have finished. Allocations can be moved to the
+// front by update to reduce fragmentation. All data is written through an
+// UploadQueue so an allocation can only be rendered once is_ready returns true
+class BufferArena {
+public:
+  // Identifies an allocation. The range of an allocation can change when it
+  // gets moved by update
+  using Handle = uint32_t;
+  static constexpr Handle invalid_handle = static_cast<Handle>(-1);
+
+  // The location of an allocation
+  struct Range {
+    // Index of the buffer which contains the range
+    uint32_t buffer;
+    vk::DeviceSize offset;
+    vk::DeviceSize size;
+  };
+
+  struct Statistics {
+    size_t buffer_count{0};
+    size_t allocation_count{0};
+    size_t free_range_count{0};
+    vk::DeviceSize capacity{0};
+    vk::DeviceSize used{0};
+    vk::DeviceSize largest_free_range{0};
+    // 0 if all free memory forms one range and approaching 1 the more the
+    // free memory is split into small ranges
+    float fragmentation{0.0f};
+  };
+
+  // The fragmentation above which update starts moving allocations
+  static constexpr float compaction_threshold = 0.25f;
+  // How many bytes update moves at most per call
+  static constexpr vk::DeviceSize default_compaction_bytes = 1024 * 1024;
+
+  // upload_queue . uploads the data of the allocations and moves them
+  // usage ........ how the buffers are used. Vertex and index buffers are
+  //                bound together
+  // buffer_size .. the size of every buffer. Larger allocations get their
+  //                own buffer
+  // alignment .... every range starts at a multiple of alignment
+  BufferArena(const Context &context, UploadQueue &upload_queue,
+              const vk::BufferUsageFlags usage,
+              const vk::DeviceSize buffer_size,
+              const vk::DeviceSize alignment);
+
+  BufferArena(const BufferArena &) = delete;
+  BufferArena &operator=(const BufferArena &) = delete;
+
+  // Allocates a range of size bytes and queues the upload of data into it
+  Handle allocate(const void *data, const vk::DeviceSize size);
+  // Releases the range of handle. The range is reused after the frames in
+  // flight have finished. Can be called from any thread
+  void free(const Handle handle);
+  // Releases the ranges freed some frames ago and moves allocations to the
+  // front of the buffers if the memory is too fragmented. Needs to be called
+  // once per frame before any rendering and after UploadQueue::update
+  void update(
+      const vk::DeviceSize max_compaction_bytes = default_compaction_bytes);
+
+  // Returns wether the data of handle has been uploaded
+  inline bool is_ready(const Handle handle) const {
+    const auto &allocation{m_allocations[handle]};
+    // Allocations are only moved after they have been uploaded
+    return allocation.moved_range.size != 0 ||
+           m_upload_queue.is_complete(allocation.upload);
+  }
+  // Returns the range from which handle can be rendered
+  inline const Range &get_range(const Handle handle) const {
+    return m_allocations[handle].range;
+  }
+  // Binds the buffer with the given index
+  inline void bind(const RenderCall &render_call, const uint32_t buffer) const {
+    m_buffers[buffer].buffer->bind(render_call);
+  }
+
+  Statistics get_statistics() const;
+
+private:
+  // Amount of calls to update until a freed range can be used again. It is
+  // larger than the maximum amount of frames in flight
+  static constexpr uint64_t release_delay = 3;
+
+  struct ArenaBuffer {
+    std::unique_ptr<Buffer> buffer;
+    // The free ranges mapped from their offset to their size
+    std::map<vk::DeviceSize, vk::DeviceSize> free_ranges;
+    // The allocations mapped from their offset to their handle
+    std::map<vk::DeviceSize, Handle> allocations;
+  };
+
+  struct Allocation {
+    // The range which is used for rendering
+    Range range;
+    // The range into which the allocation is being moved. The allocation is
+    // rendered from range until the copy has finished. Its size is 0 if the
+    // allocation is not being moved
+    Range moved_range;
+    // The upload or copy which writes the data of the allocation
+    UploadQueue::Ticket upload;
+  };
+
+  struct PendingFree {
+    Range range;
+    // The value of m_frame when the range has been freed
+    uint64_t frame;
+    // The last copy which could still write into the range
+    UploadQueue::Ticket upload;
+  };
+
+  // Returns a free range of size bytes and removes it from the free list. The
+  // range is placed at the lowest possible offset of the first buffer in which
+  // it fits. Only the buffers up to last_buffer are searched and inside of
+  // last_buffer the range needs to end before end_offset. Returns a range with
+  // a size of 0 if none has been found
+  Range _take_free_range(const vk::DeviceSize size, const uint32_t last_buffer,
+                         const vk::DeviceSize end_offset);
+  // Adds range to the free list of its buffer and merges it with its
+  // neighbours
+  void _add_free_range(const Range &range);
+  // Creates a new buffer which can hold at least size bytes and returns its
+  // index
+  uint32_t _create_buffer(const vk::DeviceSize size);
+  // Moves allocations from the back of the buffers into free ranges further
+  // at the front
+  void _compact(vk::DeviceSize max_bytes);
+  // Starts rendering the moved allocations from their new ranges once their
+  // copies have finished
+  void _finish_moves();
+
+  inline vk::DeviceSize _align(const vk::DeviceSize size) const {
+    return (size + m_alignment - 1) / m_alignment * m_alignment;
+  }
+
+  std::vector<ArenaBuffer> m_buffers;
+  std::vector<Allocation> m_allocations;
+  std::vector<Handle> m_free_handles;
+  // The handles of the allocations which are being moved
+  std::vector<Handle> m_moving_handles;
+
+  // The ranges which are waiting for the frames in flight to finish
+  std::vector<PendingFree> m_pending_frees;
+  // free can be called from any thread so it only adds the handle to this
+  // list which is then processed by update
+  std::vector<Handle> m_freed_handles;
+  std::mutex m_freed_handles_mutex;
+  // Counts the calls to update
+  uint64_t m_frame;
+
+  const vk::BufferUsageFlags m_usage;
+  const vk::DeviceSize m_buffer_size;
+  const vk::DeviceSize m_alignment;
+  const Context &m_context;
+  UploadQueue &m_upload_queue;
+};
+} // namespace vulkan
+} // namespace core
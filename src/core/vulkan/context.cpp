@@ -1,6 +1,7 @@
 #include "context.hpp"
 #include "../exception.hpp"
 #include "../log.hpp"
+#include "../profiler.hpp"
 #include "graphics_pipeline.hpp"
 #include <array>
 #include <cstring>
@@ -50,6 +51,16 @@ Context::QueueFamilyIndices::QueueFamilyIndices(
 
     i++;
   }
+
+  for (uint32_t j = 0; j < queue_families.size(); j++) {
+    const auto flags{queue_families[j].queueFlags};
+    if ((flags & vk::QueueFlagBits::eTransfer) &&
+        !(flags & vk::QueueFlagBits::eGraphics) &&
+        !(flags & vk::QueueFlagBits::eCompute)) {
+      transfer_family = j;
+      break;
+    }
+  }
 }
 
 Context::SwapChainSupportDetails::SwapChainSupportDetails(
@@ -60,7 +71,7 @@ Context::SwapChainSupportDetails::SwapChainSupportDetails(
 
 Context::PhysicalDeviceInfo::PhysicalDeviceInfo(
     const vk::PhysicalDevice &device, const vk::SurfaceKHR &surface)
-    : properties(device.getProperties()),
+    : properties(device.getProperties()), features(device.getFeatures()),
       depth_format(_find_depth_format(device)),
       queue_family_indices(device, surface),
       max_msaa_samples(_get_max_usable_sample_count(properties)),
@@ -129,6 +140,7 @@ Context::Context(Window &window, Settings &settings)
   _create_swap_chain(window);
   _allocate_command_buffers();
   _create_sync_objects();
+  _create_gpu_profiler();
 
   // Handle framebuffer resize
   window.set_on_resize([&](auto, auto) { m_framebuffer_resized = true; });
@@ -139,11 +151,13 @@ Context::Context(Window &window, Settings &settings)
 Context::~Context() {
   m_device.waitIdle();
 
+  m_gpu_profiler.reset();
   m_swap_chain.reset();
 
   for (size_t i = 0; i < _max_images_in_flight; i++) {
     m_device.destroySemaphore(m_render_finished_semaphores[i]);
     m_device.destroySemaphore(m_image_available_semaphores[i]);
+    m_device.destroySemaphore(m_upload_finished_semaphores[i]);
     m_device.destroyFence(m_in_flight_fences[i]);
   }
 
@@ -234,11 +248,16 @@ uint32_t Context::find_memory_type(uint32_t type_filter,
 }
 
 std::optional<RenderCall> Context::render_begin() {
+  VULKANKRAFT_PROFILE_ZONE("Context::render_begin");
   if (m_device.waitForFences(m_in_flight_fences[m_current_frame], VK_TRUE,
                              std::numeric_limits<uint64_t>::max()) !=
       vk::Result::eSuccess) {
     return std::nullopt;
   }
+  // The GPU has finished the last frame which used these queries
+  if (m_gpu_profiler) {
+    m_gpu_profiler->read_results(m_current_frame);
+  }
 
   auto acquired_image = m_swap_chain->acquire_next_image(
       m_device, m_image_available_semaphores[m_current_frame]);
@@ -262,6 +281,7 @@ std::optional<RenderCall> Context::render_begin() {
       this, m_graphic_command_buffers[image_index], framebuffer, image_index,
       m_image_available_semaphores[m_current_frame],
       m_render_finished_semaphores[m_current_frame],
+      m_upload_finished_semaphores[m_current_frame],
       m_in_flight_fences[m_current_frame]);
 }
 
@@ -533,6 +553,9 @@ void Context::_create_logical_device(
   std::vector<vk::DeviceQueueCreateInfo> qis;
   std::set<uint32_t> unique_queue_families = {indices.graphics_family.value(),
                                               indices.present_family.value()};
+  if (indices.transfer_family) {
+    unique_queue_families.emplace(indices.transfer_family.value());
+  }
 
   const float queue_priority = 1.0f;
   for (const auto &qf : unique_queue_families) {
@@ -546,6 +569,11 @@ void Context::_create_logical_device(
   vk::PhysicalDeviceFeatures features;
   features.samplerAnisotropy = VK_FALSE;
   features.sampleRateShading = VK_FALSE;
+  // Used to render all chunks with a few indirect draw calls
+  features.multiDrawIndirect =
+      m_physical_device_info->features.multiDrawIndirect;
+  features.drawIndirectFirstInstance =
+      m_physical_device_info->features.drawIndirectFirstInstance;
 
   vk::DeviceCreateInfo di;
   di.queueCreateInfoCount = static_cast<uint32_t>(qis.size());
@@ -567,6 +595,9 @@ void Context::_create_logical_device(
 
   m_graphics_queue = m_device.getQueue(indices.graphics_family.value(), 0);
   m_present_queue = m_device.getQueue(indices.present_family.value(), 0);
+  m_transfer_queue = indices.transfer_family
+                         ? m_device.getQueue(indices.transfer_family.value(), 0)
+                         : m_graphics_queue;
 }
 
 void Context::_create_command_pool() {
@@ -608,6 +639,7 @@ void Context::_allocate_command_buffers() {
 void Context::_create_sync_objects() {
   m_image_available_semaphores.resize(_max_images_in_flight);
   m_render_finished_semaphores.resize(_max_images_in_flight);
+  m_upload_finished_semaphores.resize(_max_images_in_flight);
   m_in_flight_fences.resize(_max_images_in_flight);
   m_images_in_flight.resize(m_swap_chain->get_image_count(), VK_NULL_HANDLE);
 
@@ -620,6 +652,7 @@ void Context::_create_sync_objects() {
     try {
       m_image_available_semaphores[i] = m_device.createSemaphore(si);
       m_render_finished_semaphores[i] = m_device.createSemaphore(si);
+      m_upload_finished_semaphores[i] = m_device.createSemaphore(si);
       m_in_flight_fences[i] = m_device.createFence(fi);
     } catch (const std::runtime_error &e) {
       throw VulkanKraftException(
@@ -629,6 +662,27 @@ void Context::_create_sync_objects() {
   }
 }
 
+void Context::_create_gpu_profiler() {
+  if (!m_settings.gpu_profiling) {
+    return;
+  }
+
+  const auto &indices{m_physical_device_info->queue_family_indices};
+  const auto valid_bits{
+      m_physical_device.getQueueFamilyProperties()[indices.graphics_family
+                                                       .value()]
+          .timestampValidBits};
+  if (valid_bits == 0) {
+    Log::warning("GPU profiling is not supported by the graphics queue");
+    return;
+  }
+
+  m_gpu_profiler = std::make_unique<GpuProfiler>(
+      m_device, m_physical_device_info->properties.limits.timestampPeriod,
+      valid_bits, _max_images_in_flight,
+      m_settings.settings_folder / _gpu_timings_file_name);
+}
+
 void Context::_handle_framebuffer_resize() {
   m_device.waitIdle();
 
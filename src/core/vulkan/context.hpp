@@ -1,6 +1,7 @@
 #pragma once
 #include "../settings.hpp"
 #include "../window.hpp"
+#include "gpu_profiler.hpp"
 #include "render_call.hpp"
 #include "swap_chain.hpp"
 #include <memory>
@@ -15,7 +16,7 @@ namespace vulkan {
 // vulkan
 class Context {
 public:
-  // Stores indices for the graphics and present queue family
+  // Stores indices for the graphics, present and transfer queue family
   class QueueFamilyIndices {
   public:
     // Retrieves the indices from the physical device and surface
@@ -28,6 +29,9 @@ public:
 
     std::optional<uint32_t> graphics_family;
     std::optional<uint32_t> present_family;
+    // A queue family which only supports transfer operations. GPUs with such
+    // a family can copy data while rendering. Not every GPU has one
+    std::optional<uint32_t> transfer_family;
   };
 
   // This class holds information about the support of the swap chain
@@ -52,6 +56,9 @@ public:
                        const vk::SurfaceKHR &surface);
 
     const vk::PhysicalDeviceProperties properties;
+    // The features supported by the physical device. Only the optional
+    // features used by the game are enabled on the logical device
+    const vk::PhysicalDeviceFeatures features;
     // The format choosen for depth textures and attachments
     const vk::Format depth_format;
     const QueueFamilyIndices queue_family_indices;
@@ -117,6 +124,26 @@ public:
     _end_single_time_commands(m_device, m_graphic_command_pool,
                               m_graphics_queue, std::move(buffer));
   }
+  // Returns the queue used to upload data. It is the graphics queue if the
+  // GPU does not have a dedicated transfer queue
+  inline const vk::Queue &get_transfer_queue() const noexcept {
+    return m_transfer_queue;
+  }
+  inline uint32_t get_transfer_queue_family() const noexcept {
+    const auto &indices{m_physical_device_info->queue_family_indices};
+    return indices.transfer_family.value_or(indices.graphics_family.value());
+  }
+  // Returns wether uploads are executed on a different queue family than the
+  // rendering. The device local buffers are shared between both families then
+  inline bool has_dedicated_transfer_queue() const noexcept {
+    return m_physical_device_info->queue_family_indices.transfer_family
+        .has_value();
+  }
+  // Returns the GPU timings of a previous frame. Is null if GPU profiling is
+  // disabled
+  inline const GpuProfiler *get_gpu_profiler() const noexcept {
+    return m_gpu_profiler.get();
+  }
   // ***************************
 
   // **** utility methods *******
@@ -150,6 +177,8 @@ private:
   static constexpr bool _enable_validation_layers = true;
 #endif
   static constexpr size_t _max_images_in_flight = 2;
+  // The GPU timings are written into this file in the settings folder
+  static constexpr char _gpu_timings_file_name[] = "gpu_timings.csv";
   // *********************************
 
   // ******* validation layers *******
@@ -217,6 +246,8 @@ private:
   void _allocate_command_buffers();
   // Create semaphores and fences for syncing
   void _create_sync_objects();
+  // Create the GPU profiler if it is enabled and timestamps are supported
+  void _create_gpu_profiler();
   // ****************************
 
   // A callback used to handle the resize of the framebuffer (or window)
@@ -231,6 +262,8 @@ private:
   vk::Queue m_graphics_queue;
   // Queue used to execute commands for presenting to the surface
   vk::Queue m_present_queue;
+  // Queue used to upload data
+  vk::Queue m_transfer_queue;
   std::unique_ptr<SwapChain> m_swap_chain;
   // Command pool for all graphics command buffers
   vk::CommandPool m_graphic_command_pool;
@@ -239,9 +272,13 @@ private:
 
   std::vector<vk::Semaphore> m_image_available_semaphores;
   std::vector<vk::Semaphore> m_render_finished_semaphores;
+  // Signaled by the uploads of a frame and waited for by its rendering
+  std::vector<vk::Semaphore> m_upload_finished_semaphores;
   std::vector<vk::Fence> m_in_flight_fences;
   std::vector<vk::Fence> m_images_in_flight;
 
+  std::unique_ptr<GpuProfiler> m_gpu_profiler;
+
   size_t m_current_frame;
   bool m_framebuffer_resized;
   std::unique_ptr<PhysicalDeviceInfo> m_physical_device_info;
@@ -0,0 +1,133 @@
+#include "gpu_profiler.hpp"
+#include "../exception.hpp"
+#include "../log.hpp"
+#include <algorithm>
+
+namespace core {
+namespace vulkan {
+GpuProfiler::GpuProfiler(const vk::Device &device, const float timestamp_period,
+                         const uint32_t valid_bits, const size_t frame_count,
+                         const std::filesystem::path &csv_file_name)
+    : m_frames(frame_count), m_current(nullptr),
+      m_results(query_count), m_timestamp_period(timestamp_period),
+      m_timestamp_mask(valid_bits >= 64 ? ~uint64_t(0)
+                                        : (uint64_t(1) << valid_bits) - 1),
+      m_csv_file(csv_file_name), m_frame_number(0), m_device(device) {
+  vk::QueryPoolCreateInfo qi;
+  qi.queryType = vk::QueryType::eTimestamp;
+  qi.queryCount = query_count;
+
+  for (auto &frame : m_frames) {
+    try {
+      frame.pool = m_device.createQueryPool(qi);
+    } catch (const std::runtime_error &e) {
+      throw VulkanKraftException(
+          std::string("failed to create timestamp query pool: ") + e.what());
+    }
+    frame.scope_names.reserve(max_scopes);
+  }
+
+  if (m_csv_file.fail()) {
+    Log::warning("failed to open GPU timings file \"" +
+                 csv_file_name.string() + "\"");
+  } else {
+    m_csv_file << "frame,scope,milliseconds\n";
+  }
+}
+
+GpuProfiler::~GpuProfiler() {
+  for (const auto &frame : m_frames) {
+    m_device.destroyQueryPool(frame.pool);
+  }
+}
+
+void GpuProfiler::read_results(const size_t frame_index) {
+  auto &frame{m_frames[frame_index]};
+  if (!frame.recorded) {
+    return;
+  }
+  frame.recorded = false;
+
+  const auto count{2 + static_cast<uint32_t>(frame.scope_names.size()) * 2};
+  // The fence of the frame has been signaled, so the results are available
+  // and nothing is waited for
+  if (m_device.getQueryPoolResults(
+          frame.pool, 0, count, sizeof(uint64_t) * count, m_results.data(),
+          sizeof(uint64_t), vk::QueryResultFlagBits::e64) !=
+      vk::Result::eSuccess) {
+    return;
+  }
+
+  const auto to_milliseconds{[&](const uint32_t begin) {
+    const auto ticks{(m_results[begin + 1] - m_results[begin]) &
+                     m_timestamp_mask};
+    return static_cast<float>(static_cast<double>(ticks) *
+                              m_timestamp_period * 1e-6);
+  }};
+
+  m_timings.clear();
+  m_timings.push_back(Timing{frame_scope_name, to_milliseconds(0)});
+  for (size_t i = 0; i < frame.scope_names.size(); i++) {
+    const auto milliseconds{to_milliseconds(2 + static_cast<uint32_t>(i) * 2)};
+    if (auto timing{std::find_if(m_timings.begin() + 1, m_timings.end(),
+                                 [&](const Timing &t) {
+                                   return t.name == frame.scope_names[i];
+                                 })};
+        timing != m_timings.end()) {
+      timing->milliseconds += milliseconds;
+    } else {
+      m_timings.push_back(Timing{frame.scope_names[i], milliseconds});
+    }
+  }
+
+  if (m_csv_file.is_open()) {
+    for (const auto &timing : m_timings) {
+      m_csv_file << m_frame_number << ',' << timing.name << ','
+                 << timing.milliseconds << '\n';
+    }
+  }
+  m_frame_number++;
+}
+
+void GpuProfiler::begin_frame(const vk::CommandBuffer &command_buffer,
+                              const size_t frame_index) {
+  m_current = &m_frames[frame_index];
+  m_current->scope_names.clear();
+  m_current->recorded = true;
+
+  command_buffer.resetQueryPool(m_current->pool, 0, query_count);
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe,
+                                m_current->pool, 0);
+}
+
+void GpuProfiler::end_frame(const vk::CommandBuffer &command_buffer) {
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                m_current->pool, 1);
+  m_current = nullptr;
+}
+
+uint32_t GpuProfiler::begin_scope(const vk::CommandBuffer &command_buffer,
+                                  const char *name) {
+  if (!m_current || m_current->scope_names.size() == max_scopes) {
+    return invalid_scope;
+  }
+
+  const auto scope{static_cast<uint32_t>(m_current->scope_names.size())};
+  m_current->scope_names.push_back(name);
+  // The scope starts when all previous commands have finished
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                m_current->pool, 2 + scope * 2);
+  return scope;
+}
+
+void GpuProfiler::end_scope(const vk::CommandBuffer &command_buffer,
+                            const uint32_t scope) {
+  if (!m_current || scope == invalid_scope) {
+    return;
+  }
+
+  command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe,
+                                m_current->pool, 3 + scope * 2);
+}
+} // namespace vulkan
+} // namespace core
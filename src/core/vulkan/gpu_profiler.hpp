@@ -0,0 +1,85 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+namespace core {
+namespace vulkan {
+// Measures the GPU time of named scopes of a frame with timestamp queries.
+// Every frame in flight has its own query pool. Its results are read after the
+// fence of the frame has been waited on, so reading them never stalls. The
+// timings are additionally appended to a CSV file
+class GpuProfiler {
+public:
+  // The measured time of one scope. Scopes with the same name are summed up
+  struct Timing {
+    std::string name;
+    float milliseconds;
+  };
+
+  // Is returned by begin_scope if no query is left
+  static constexpr uint32_t invalid_scope = ~0u;
+  // The most scopes one frame can have
+  static constexpr uint32_t max_scopes = 32;
+  // The name of the timing which spans the whole frame
+  static constexpr char frame_scope_name[] = "frame";
+
+  // timestamp_period ... nanoseconds per timestamp tick
+  // valid_bits ......... how many bits of a timestamp are valid
+  GpuProfiler(const vk::Device &device, const float timestamp_period,
+              const uint32_t valid_bits, const size_t frame_count,
+              const std::filesystem::path &csv_file_name);
+  ~GpuProfiler();
+
+  GpuProfiler(const GpuProfiler &) = delete;
+  GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+  // Reads the timestamps of frame. The GPU needs to have finished the frame
+  void read_results(const size_t frame);
+  // Resets the queries of frame and writes the timestamp of its beginning.
+  // Needs to be recorded outside of a render pass
+  void begin_frame(const vk::CommandBuffer &command_buffer, const size_t frame);
+  // Writes the timestamp of the end of the current frame
+  void end_frame(const vk::CommandBuffer &command_buffer);
+  // Writes the timestamp of the beginning of a scope and returns the scope
+  uint32_t begin_scope(const vk::CommandBuffer &command_buffer,
+                       const char *name);
+  // Writes the timestamp of the end of scope
+  void end_scope(const vk::CommandBuffer &command_buffer,
+                 const uint32_t scope);
+
+  // Returns the timings of the last frame whose results have been read. The
+  // frame timing is always the first
+  inline const std::vector<Timing> &get_timings() const { return m_timings; }
+
+private:
+  // The queries of one frame in flight
+  struct Frame {
+    vk::QueryPool pool;
+    // The names of the scopes. Scope i uses the queries 2 + 2i and 3 + 2i
+    std::vector<const char *> scope_names;
+    // Wether timestamps have been recorded that have not been read yet
+    bool recorded{false};
+  };
+
+  // The frame begin and end are the first two queries
+  static constexpr uint32_t query_count = 2 + max_scopes * 2;
+
+  std::vector<Frame> m_frames;
+  // The frame which is currently being recorded
+  Frame *m_current;
+  std::vector<Timing> m_timings;
+  std::vector<uint64_t> m_results;
+  const float m_timestamp_period;
+  const uint64_t m_timestamp_mask;
+
+  std::ofstream m_csv_file;
+  // Counts the frames written into the CSV file
+  uint64_t m_frame_number;
+
+  const vk::Device &m_device;
+};
+} // namespace vulkan
+} // namespace core
@@ -9,14 +9,14 @@ GraphicsPipeline::GraphicsPipeline(
     const Context &context,
     std::vector<vk::DescriptorSetLayout> descriptor_set_layouts,
     const SPVData &vertex_code, const SPVData &fragment_code,
-    vk::VertexInputBindingDescription vertex_binding,
+    std::vector<vk::VertexInputBindingDescription> vertex_bindings,
     std::vector<vk::VertexInputAttributeDescription> vertex_attributes,
     const vk::SampleCountFlagBits msaa_samples, const bool alpha_blending,
     const std::vector<vk::PushConstantRange> &push_constant_ranges,
     const vk::PrimitiveTopology primitive_topology)
     : m_context(context) {
   _create_handle(std::move(descriptor_set_layouts), vertex_code, fragment_code,
-                 std::move(vertex_binding), std::move(vertex_attributes),
+                 std::move(vertex_bindings), std::move(vertex_attributes),
                  msaa_samples, alpha_blending, push_constant_ranges,
                  primitive_topology);
 }
@@ -45,7 +45,7 @@ GraphicsPipeline::_create_shader_module(const vk::Device &device,
 void GraphicsPipeline::_create_handle(
     std::vector<vk::DescriptorSetLayout> descriptor_set_layouts,
     const SPVData &vertex_code, const SPVData &fragment_code,
-    vk::VertexInputBindingDescription vertex_binding,
+    std::vector<vk::VertexInputBindingDescription> vertex_bindings,
     std::vector<vk::VertexInputAttributeDescription> vertex_attributes,
     const vk::SampleCountFlagBits msaa_samples, const bool alpha_blending,
     const std::vector<vk::PushConstantRange> &push_constant_ranges,
@@ -79,10 +79,11 @@ void GraphicsPipeline::_create_handle(
   const auto shader_stages = std::array{vert_i, frag_i};
 
   vk::PipelineVertexInputStateCreateInfo vi_i;
-  vi_i.vertexBindingDescriptionCount = !vertex_attributes.empty();
+  vi_i.vertexBindingDescriptionCount =
+      static_cast<uint32_t>(vertex_bindings.size());
   vi_i.vertexAttributeDescriptionCount =
       static_cast<uint32_t>(vertex_attributes.size());
-  vi_i.pVertexBindingDescriptions = &vertex_binding;
+  vi_i.pVertexBindingDescriptions = vertex_bindings.data();
   vi_i.pVertexAttributeDescriptions = vertex_attributes.data();
 
   vk::PipelineInputAssemblyStateCreateInfo ia_i;
@@ -22,7 +22,7 @@ public:
       const Context &context,
       std::vector<vk::DescriptorSetLayout> descriptor_set_layouts,
       const SPVData &vertex_code, const SPVData &fragment_code,
-      vk::VertexInputBindingDescription vertex_binding,
+      std::vector<vk::VertexInputBindingDescription> vertex_bindings,
       std::vector<vk::VertexInputAttributeDescription> vertex_attributes,
       const vk::SampleCountFlagBits msaa_samples, const bool alpha_blending,
       const std::vector<vk::PushConstantRange> &push_constant_ranges,
@@ -45,7 +45,7 @@ private:
   void _create_handle(
       std::vector<vk::DescriptorSetLayout> descriptor_set_layout,
       const SPVData &vertex_code, const SPVData &fragment_code,
-      vk::VertexInputBindingDescription vertex_binding,
+      std::vector<vk::VertexInputBindingDescription> vertex_bindings,
       std::vector<vk::VertexInputAttributeDescription> vertex_attributes,
       const vk::SampleCountFlagBits msaa_samples, const bool alpha_blending,
       const std::vector<vk::PushConstantRange> &push_constant_ranges,
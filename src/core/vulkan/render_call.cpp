@@ -1,21 +1,43 @@
 #include "render_call.hpp"
 #include "../exception.hpp"
+#include "../profiler.hpp"
 #include "context.hpp"
 
 namespace core {
 namespace vulkan {
+RenderCall::GpuScope::GpuScope(const RenderCall &render_call,
+                               const char *name)
+    : m_render_call(render_call),
+      m_scope(render_call.m_gpu_profiler
+                  ? render_call.m_gpu_profiler->begin_scope(
+                        render_call.m_graphics_buffer, name)
+                  : GpuProfiler::invalid_scope) {}
+
+RenderCall::GpuScope::~GpuScope() {
+  if (m_render_call.m_gpu_profiler) {
+    m_render_call.m_gpu_profiler->end_scope(m_render_call.m_graphics_buffer,
+                                            m_scope);
+  }
+}
+
 RenderCall::RenderCall(Context *context,
                        const vk::CommandBuffer &graphics_buffer,
                        const vk::Framebuffer &framebuffer,
                        const uint32_t swap_chain_image_index,
                        const vk::Semaphore &image_available_semaphore,
                        const vk::Semaphore &render_finished_semaphore,
+                       const vk::Semaphore &upload_finished_semaphore,
                        const vk::Fence &in_flight_fence)
     : m_graphics_buffer(graphics_buffer), m_image_index(swap_chain_image_index),
       m_image_available_semaphore(image_available_semaphore),
       m_render_finished_semaphore(render_finished_semaphore),
-      m_in_flight_fence(in_flight_fence), m_context(context) {
+      m_upload_finished_semaphore(upload_finished_semaphore),
+      m_wait_for_uploads(false), m_in_flight_fence(in_flight_fence),
+      m_gpu_profiler(context->m_gpu_profiler.get()), m_context(context) {
   m_graphics_buffer.begin(vk::CommandBufferBeginInfo());
+  if (m_gpu_profiler) {
+    m_gpu_profiler->begin_frame(m_graphics_buffer, m_context->m_current_frame);
+  }
 
   vk::RenderPassBeginInfo rbi;
   rbi.renderPass = m_context->get_swap_chain_render_pass();
@@ -52,15 +74,24 @@ RenderCall::RenderCall(Context *context,
 }
 
 RenderCall::~RenderCall() {
+  VULKANKRAFT_PROFILE_ZONE("RenderCall::~RenderCall");
   m_graphics_buffer.endRenderPass();
+  if (m_gpu_profiler) {
+    m_gpu_profiler->end_frame(m_graphics_buffer);
+  }
   m_graphics_buffer.end();
 
   vk::SubmitInfo si;
 
-  const auto wait_sems = std::array{m_image_available_semaphore};
+  // The copies of the uploads need to be visible to the vertex input. Waiting
+  // for their fence on the host does not make them visible
+  const auto wait_sems =
+      std::array{m_image_available_semaphore, m_upload_finished_semaphore};
   const auto wait_stages = std::array<vk::PipelineStageFlags, wait_sems.size()>{
-      vk::PipelineStageFlagBits::eColorAttachmentOutput};
-  si.waitSemaphoreCount = static_cast<uint32_t>(wait_sems.size());
+      vk::PipelineStageFlagBits::eColorAttachmentOutput,
+      vk::PipelineStageFlagBits::eVertexInput};
+  si.waitSemaphoreCount =
+      static_cast<uint32_t>(m_wait_for_uploads ? wait_sems.size() : 1);
   si.pWaitSemaphores = wait_sems.data();
   si.pWaitDstStageMask = wait_stages.data();
   si.commandBufferCount = 1;
@@ -105,8 +136,19 @@ void RenderCall::render_vertices(const uint32_t num_vertices,
 }
 
 void RenderCall::render_indices(const uint32_t num_indices,
-                                const uint32_t first_index) const noexcept {
-  m_graphics_buffer.drawIndexed(num_indices, 1, first_index, 0, 0);
+                                const uint32_t first_index,
+                                const int32_t vertex_offset,
+                                const uint32_t first_instance) const noexcept {
+  m_graphics_buffer.drawIndexed(num_indices, 1, first_index, vertex_offset,
+                                first_instance);
+}
+
+void RenderCall::render_indices_indirect(
+    const vk::Buffer &buffer, const vk::DeviceSize offset,
+    const uint32_t draw_count) const noexcept {
+  m_graphics_buffer.drawIndexedIndirect(
+      buffer, offset, draw_count,
+      static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand)));
 }
 
 void RenderCall::bind_graphics_pipeline(
@@ -123,16 +165,32 @@ void RenderCall::bind_descriptor_set(const vk::DescriptorSet &set,
 
 void RenderCall::bind_buffer(const vk::Buffer &buffer,
                              vk::BufferUsageFlags usage) const {
+  if (!(usage & (vk::BufferUsageFlagBits::eIndexBuffer |
+                 vk::BufferUsageFlagBits::eVertexBuffer))) {
+    throw VulkanKraftException(
+        "invalid buffer usage for core::vulkan::RenderCall::bind_buffer");
+  }
+
   if (usage & vk::BufferUsageFlagBits::eIndexBuffer) {
     m_graphics_buffer.bindIndexBuffer(buffer, 0, vk::IndexType::eUint32);
-  } else if (usage & vk::BufferUsageFlagBits::eVertexBuffer) {
+  }
+  if (usage & vk::BufferUsageFlagBits::eVertexBuffer) {
     m_graphics_buffer.bindVertexBuffers(0, buffer,
                                         static_cast<vk::DeviceSize>(0));
-  } else {
-    throw VulkanKraftException(
-        "invalid buffer usage for core::vulkan::RenderCall::bind_buffer");
   }
 }
 
+void RenderCall::bind_index_buffer(const vk::Buffer &buffer,
+                                   const vk::IndexType type,
+                                   const vk::DeviceSize offset) const noexcept {
+  m_graphics_buffer.bindIndexBuffer(buffer, offset, type);
+}
+
+void RenderCall::bind_vertex_buffer(
+    const vk::Buffer &buffer, const uint32_t binding,
+    const vk::DeviceSize offset) const noexcept {
+  m_graphics_buffer.bindVertexBuffers(binding, buffer, offset);
+}
+
 } // namespace vulkan
 } // namespace core
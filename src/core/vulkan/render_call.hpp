@@ -1,4 +1,5 @@
 #pragma once
+#include "gpu_profiler.hpp"
 #include <vulkan/vulkan.hpp>
 
 namespace core {
@@ -9,6 +10,21 @@ class Context;
 // be instanciated using Context::render_begin
 class RenderCall {
 public:
+  // Measures the GPU time of the commands recorded during its lifetime. Does
+  // nothing if GPU profiling is disabled
+  class GpuScope {
+  public:
+    GpuScope(const RenderCall &render_call, const char *name);
+    ~GpuScope();
+
+    GpuScope(const GpuScope &) = delete;
+    GpuScope &operator=(const GpuScope &) = delete;
+
+  private:
+    const RenderCall &m_render_call;
+    const uint32_t m_scope;
+  };
+
   // Returns the index of the currently used swap chain image
   inline const uint32_t &get_swap_chain_image_index() const {
     return m_image_index;
@@ -19,6 +35,7 @@ public:
              const uint32_t swap_chain_image_index,
              const vk::Semaphore &image_available_semaphore,
              const vk::Semaphore &render_finished_semaphore,
+             const vk::Semaphore &upload_finished_semaphore,
              const vk::Fence &in_flight_fence);
   // Stops recording commands and executes the render call
   ~RenderCall();
@@ -26,9 +43,16 @@ public:
   // Render an given amount of vertices
   void render_vertices(const uint32_t num_vertices,
                        const uint32_t first_vertex = 0) const noexcept;
-  // Render an given amount of indices
+  // Render an given amount of indices. vertex_offset is added to every index
   void render_indices(const uint32_t num_indices,
-                      const uint32_t first_index = 0) const noexcept;
+                      const uint32_t first_index = 0,
+                      const int32_t vertex_offset = 0,
+                      const uint32_t first_instance = 0) const noexcept;
+  // Execute draw_count vk::DrawIndexedIndirectCommand stored in buffer at
+  // offset. More than one draw requires the multiDrawIndirect feature
+  void render_indices_indirect(const vk::Buffer &buffer,
+                               const vk::DeviceSize offset,
+                               const uint32_t draw_count) const noexcept;
 
   // Bind the given pipeline
   void bind_graphics_pipeline(const vk::Pipeline &pipeline) const noexcept;
@@ -38,6 +62,26 @@ public:
                            const uint32_t set_index) const noexcept;
   // Bind a buffer either as vertex or index or both
   void bind_buffer(const vk::Buffer &buffer, vk::BufferUsageFlags usage) const;
+  // Bind an index buffer whose indices have the given type
+  void bind_index_buffer(const vk::Buffer &buffer, const vk::IndexType type,
+                         const vk::DeviceSize offset = 0) const noexcept;
+  // Bind a vertex buffer to the given binding starting at offset
+  void bind_vertex_buffer(const vk::Buffer &buffer, const uint32_t binding,
+                          const vk::DeviceSize offset = 0) const noexcept;
+
+  // Returns the semaphore which the uploads of this frame signal
+  inline const vk::Semaphore &get_upload_semaphore() const {
+    return m_upload_finished_semaphore;
+  }
+  // Lets the vertex input of this and all later render calls wait for the
+  // upload semaphore. It needs to be signaled before the render call ends
+  inline void wait_for_uploads() const noexcept { m_wait_for_uploads = true; }
+
+  // Starts a GPU scope with the given name which ends when the returned object
+  // is destroyed. name needs to be a string literal
+  inline GpuScope begin_gpu_scope(const char *name) const {
+    return GpuScope(*this, name);
+  }
 
   template <typename T>
   inline void set_push_constant(const vk::PipelineLayout &layout,
@@ -55,7 +99,14 @@ private:
   // The semaphores used to sync rendering and presenting
   const vk::Semaphore &m_image_available_semaphore;
   const vk::Semaphore &m_render_finished_semaphore;
+  // Is only waited for if wait_for_uploads has been called. Every frame in
+  // flight has its own, so the last wait for it has finished before the
+  // uploads of the frame signal it again
+  const vk::Semaphore &m_upload_finished_semaphore;
+  mutable bool m_wait_for_uploads;
   const vk::Fence &m_in_flight_fence;
+  // Is null if GPU profiling is disabled
+  GpuProfiler *m_gpu_profiler;
 
   Context *m_context;
 };
@@ -0,0 +1,276 @@
+#include "upload_queue.hpp"
+#include "../exception.hpp"
+#include <cstring>
+#include <limits>
+
+namespace core {
+namespace vulkan {
+UploadQueue::UploadQueue(const Context &context,
+                         const vk::DeviceSize staging_size)
+    : m_staging_size(staging_size), m_staging_head(0), m_staging_tail(0),
+      m_is_recording(false), m_needs_signal(false), m_next_ticket(1),
+      m_completed_ticket(0), m_context(context) {
+  const auto &device{m_context.get_device()};
+
+  vk::CommandPoolCreateInfo ci;
+  ci.queueFamilyIndex = m_context.get_transfer_queue_family();
+  ci.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer |
+             vk::CommandPoolCreateFlagBits::eTransient;
+  try {
+    m_command_pool = device.createCommandPool(ci);
+  } catch (const std::runtime_error &e) {
+    throw VulkanKraftException(
+        std::string("failed to create upload command pool: ") + e.what());
+  }
+
+  vk::BufferCreateInfo bi;
+  bi.size = m_staging_size;
+  bi.usage = vk::BufferUsageFlagBits::eTransferSrc;
+  bi.sharingMode = vk::SharingMode::eExclusive;
+  try {
+    m_staging_buffer = device.createBuffer(bi);
+  } catch (const std::runtime_error &e) {
+    throw VulkanKraftException(
+        std::string("failed to create upload staging buffer: ") + e.what());
+  }
+
+  const auto mem_req{device.getBufferMemoryRequirements(m_staging_buffer)};
+  vk::MemoryAllocateInfo ai;
+  ai.allocationSize = mem_req.size;
+  ai.memoryTypeIndex = m_context.find_memory_type(
+      mem_req.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible |
+                                  vk::MemoryPropertyFlagBits::eHostCoherent);
+  try {
+    m_staging_memory = device.allocateMemory(ai);
+  } catch (const std::runtime_error &e) {
+    throw VulkanKraftException(
+        std::string("failed to allocate memory for upload staging buffer: ") +
+        e.what());
+  }
+
+  device.bindBufferMemory(m_staging_buffer, m_staging_memory, 0);
+
+  // The memory stays mapped for the whole lifetime
+  try {
+    m_staging_data = static_cast<uint8_t *>(
+        device.mapMemory(m_staging_memory, 0, m_staging_size));
+  } catch (const std::runtime_error &e) {
+    throw VulkanKraftException(
+        std::string("failed to map memory of upload staging buffer: ") +
+        e.what());
+  }
+}
+
+UploadQueue::~UploadQueue() {
+  const auto &device{m_context.get_device()};
+
+  flush();
+  while (!m_submitted.empty()) {
+    _wait_for_oldest();
+  }
+
+  for (const auto &submission : m_free_submissions) {
+    device.destroyFence(submission.fence);
+  }
+  device.destroyCommandPool(m_command_pool);
+
+  device.unmapMemory(m_staging_memory);
+  device.destroyBuffer(m_staging_buffer);
+  device.freeMemory(m_staging_memory);
+}
+
+UploadQueue::Ticket UploadQueue::upload(const Buffer &dst,
+                                        const vk::DeviceSize offset,
+                                        const void *data,
+                                        const vk::DeviceSize size) {
+  if (size > m_staging_size) {
+    throw VulkanKraftException(
+        "tried to upload " + std::to_string(size) +
+        " bytes which is more than the size of the staging buffer (" +
+        std::to_string(m_staging_size) + " bytes)");
+  }
+
+  const auto staging_offset{_reserve_staging(size)};
+  memcpy(m_staging_data + staging_offset, data, size);
+
+  _begin_submission();
+
+  vk::BufferCopy cp;
+  cp.srcOffset = staging_offset;
+  cp.dstOffset = offset;
+  cp.size = size;
+  m_recording.command_buffer.copyBuffer(m_staging_buffer, dst.get_handle(),
+                                        cp);
+
+  return m_recording.ticket;
+}
+
+UploadQueue::Ticket UploadQueue::copy(const Buffer &src,
+                                      const vk::DeviceSize src_offset,
+                                      const Buffer &dst,
+                                      const vk::DeviceSize dst_offset,
+                                      const vk::DeviceSize size) {
+  _begin_submission();
+  // src could have been written by the uploads of this submission
+  _record_transfer_barrier();
+
+  vk::BufferCopy cp;
+  cp.srcOffset = src_offset;
+  cp.dstOffset = dst_offset;
+  cp.size = size;
+  m_recording.command_buffer.copyBuffer(src.get_handle(), dst.get_handle(),
+                                        cp);
+
+  return m_recording.ticket;
+}
+
+void UploadQueue::flush() { _submit(nullptr); }
+
+bool UploadQueue::flush(const vk::Semaphore &semaphore) {
+  if (!m_is_recording && !m_needs_signal) {
+    return false;
+  }
+
+  _submit(&semaphore);
+  return true;
+}
+
+void UploadQueue::_submit(const vk::Semaphore *semaphore) {
+  if (!m_is_recording && !semaphore) {
+    return;
+  }
+
+  vk::SubmitInfo si;
+  // A signaled semaphore also waits for all earlier submissions of the queue,
+  // so it can be signaled without any copies
+  if (m_is_recording) {
+    m_recording.command_buffer.end();
+    m_recording.staging_end = m_staging_head;
+
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &m_recording.command_buffer;
+  }
+  if (semaphore) {
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = semaphore;
+  }
+
+  try {
+    m_context.get_transfer_queue().submit(
+        si, m_is_recording ? m_recording.fence : vk::Fence());
+  } catch (const std::runtime_error &e) {
+    throw VulkanKraftException(std::string("failed to submit uploads: ") +
+                               e.what());
+  }
+
+  if (m_is_recording) {
+    m_submitted.push_back(m_recording);
+    m_is_recording = false;
+    m_needs_signal = true;
+  }
+  if (semaphore) {
+    m_needs_signal = false;
+  }
+}
+
+void UploadQueue::update() {
+  // The submissions finish in the order in which they have been submitted
+  while (!m_submitted.empty() &&
+         m_context.get_device().getFenceStatus(m_submitted.front().fence) ==
+             vk::Result::eSuccess) {
+    const auto &oldest{m_submitted.front()};
+    m_completed_ticket = oldest.ticket;
+    m_staging_tail = oldest.staging_end;
+    m_free_submissions.push_back(oldest);
+    m_submitted.pop_front();
+  }
+}
+
+void UploadQueue::_begin_submission() {
+  if (m_is_recording) {
+    return;
+  }
+
+  const auto &device{m_context.get_device()};
+
+  if (!m_free_submissions.empty()) {
+    m_recording = m_free_submissions.back();
+    m_free_submissions.pop_back();
+    device.resetFences(m_recording.fence);
+  } else {
+    vk::CommandBufferAllocateInfo ai;
+    ai.level = vk::CommandBufferLevel::ePrimary;
+    ai.commandPool = m_command_pool;
+    ai.commandBufferCount = 1;
+
+    try {
+      m_recording.command_buffer = device.allocateCommandBuffers(ai)[0];
+      m_recording.fence = device.createFence(vk::FenceCreateInfo());
+    } catch (const std::runtime_error &e) {
+      throw VulkanKraftException(
+          std::string("failed to create upload submission: ") + e.what());
+    }
+  }
+
+  m_recording.ticket = m_next_ticket++;
+
+  vk::CommandBufferBeginInfo cbi;
+  cbi.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+  m_recording.command_buffer.begin(cbi);
+  m_is_recording = true;
+
+  // The copies of this submission must not overlap with the copies of the
+  // previous submissions still being executed
+  _record_transfer_barrier();
+}
+
+vk::DeviceSize UploadQueue::_reserve_staging(const vk::DeviceSize size) {
+  auto begin{(m_staging_head + staging_alignment - 1) / staging_alignment *
+             staging_alignment};
+  // The data needs to be contiguous so the end of the buffer is skipped if it
+  // does not fit there
+  if (const auto offset{begin % m_staging_size};
+      offset + size > m_staging_size) {
+    begin += m_staging_size - offset;
+  }
+
+  while (begin + size - m_staging_tail > m_staging_size) {
+    // Nothing uses the staging buffer anymore so all of it is free
+    if (!m_is_recording && m_submitted.empty()) {
+      m_staging_tail = begin;
+      break;
+    }
+    _wait_for_oldest();
+  }
+
+  m_staging_head = begin + size;
+  return begin % m_staging_size;
+}
+
+void UploadQueue::_wait_for_oldest() {
+  // The recorded copies might still use the memory
+  if (m_submitted.empty()) {
+    flush();
+  }
+
+  if (m_context.get_device().waitForFences(
+          m_submitted.front().fence, VK_TRUE,
+          std::numeric_limits<uint64_t>::max()) != vk::Result::eSuccess) {
+    throw VulkanKraftException("failed to wait for uploads");
+  }
+  update();
+}
+
+void UploadQueue::_record_transfer_barrier() const {
+  vk::MemoryBarrier bar;
+  bar.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  bar.dstAccessMask =
+      vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+
+  m_recording.command_buffer.pipelineBarrier(
+      vk::PipelineStageFlagBits::eTransfer,
+      vk::PipelineStageFlagBits::eTransfer,
+      static_cast<vk::DependencyFlagBits>(0), bar, nullptr, nullptr);
+}
+} // namespace vulkan
+} // namespace core
@@ -0,0 +1,108 @@
+#pragma once
+#include "buffer.hpp"
+#include <deque>
+#include <vector>
+
+namespace core {
+namespace vulkan {
+// Uploads data into device local buffers without waiting for the copies to
+// finish. The data is written into a persistently mapped staging buffer which
+// is used as a ring buffer. The copies are recorded into a command buffer and
+// submitted together to the transfer queue by flush. A fence signals when
+// they have finished. The fence only tells the host that the copies have
+// finished. The graphics queue still needs to wait for a semaphore signaled by
+// flush before it can read the copied data
+class UploadQueue {
+public:
+  // Identifies the submission which executes a copy. Copies with a lower or
+  // equal ticket than the last finished submission have finished too
+  using Ticket = uint64_t;
+
+  // The size of the staging buffer if none is given
+  static constexpr vk::DeviceSize default_staging_size = 16 * 1024 * 1024;
+
+  UploadQueue(const Context &context,
+              const vk::DeviceSize staging_size = default_staging_size);
+  ~UploadQueue();
+
+  UploadQueue(const UploadQueue &) = delete;
+  UploadQueue &operator=(const UploadQueue &) = delete;
+
+  // Copies size bytes of data into dst at offset. The data is copied into the
+  // staging buffer immediately. Waits for older submissions if the staging
+  // buffer is full
+  Ticket upload(const Buffer &dst, const vk::DeviceSize offset,
+                const void *data, const vk::DeviceSize size);
+  // Copies size bytes from src to dst on the GPU. The copy is executed after
+  // all previous uploads and copies
+  Ticket copy(const Buffer &src, const vk::DeviceSize src_offset,
+              const Buffer &dst, const vk::DeviceSize dst_offset,
+              const vk::DeviceSize size);
+  // Submits all recorded copies to the transfer queue
+  void flush();
+  // Submits all recorded copies and signals semaphore once they and all
+  // copies submitted before have finished. Returns false without signaling
+  // semaphore if no copies have been submitted since the last signal
+  bool flush(const vk::Semaphore &semaphore);
+  // Checks which submissions have finished and frees their staging memory
+  void update();
+
+  // Returns wether the copy of ticket has finished
+  inline bool is_complete(const Ticket ticket) const {
+    return ticket <= m_completed_ticket;
+  }
+
+private:
+  // Every offset in the staging buffer is aligned to this
+  static constexpr vk::DeviceSize staging_alignment = 16;
+
+  // A command buffer with all copies of one submission
+  struct Submission {
+    vk::CommandBuffer command_buffer;
+    vk::Fence fence;
+    Ticket ticket;
+    // The end of the staging memory used by this submission
+    uint64_t staging_end;
+  };
+
+  // Submits the recorded copies and signals semaphore if it is not null
+  void _submit(const vk::Semaphore *semaphore);
+  // Starts recording a new submission if none is being recorded
+  void _begin_submission();
+  // Reserves size bytes of the staging buffer and returns their offset.
+  // Flushes and waits for older submissions if needed
+  vk::DeviceSize _reserve_staging(const vk::DeviceSize size);
+  // Waits until the oldest submission has finished
+  void _wait_for_oldest();
+  // Records a barrier so that the following copies happen after the previous
+  // ones
+  void _record_transfer_barrier() const;
+
+  vk::CommandPool m_command_pool;
+  vk::Buffer m_staging_buffer;
+  vk::DeviceMemory m_staging_memory;
+  uint8_t *m_staging_data;
+  const vk::DeviceSize m_staging_size;
+  // The staging buffer is used as a ring buffer. Both positions only ever
+  // grow and are wrapped around by the size of the staging buffer
+  uint64_t m_staging_head;
+  uint64_t m_staging_tail;
+
+  // The submission which is currently being recorded
+  Submission m_recording;
+  bool m_is_recording;
+  // The submitted submissions ordered from the oldest to the newest
+  std::deque<Submission> m_submitted;
+  // Finished submissions whose command buffers and fences can be reused
+  std::vector<Submission> m_free_submissions;
+  // Wether copies have been submitted since the last semaphore has been
+  // signaled
+  bool m_needs_signal;
+
+  Ticket m_next_ticket;
+  Ticket m_completed_ticket;
+
+  const Context &m_context;
+};
+} // namespace vulkan
+} // namespace core
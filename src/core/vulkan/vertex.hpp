@@ -19,6 +19,12 @@ inline constexpr vk::Format vertex_attribute_format<glm::vec3> =
 template <>
 inline constexpr vk::Format vertex_attribute_format<glm::vec4> =
     vk::Format::eR32G32B32A32Sfloat;
+template <>
+inline constexpr vk::Format vertex_attribute_format<glm::uvec2> =
+    vk::Format::eR32G32Uint;
+template <>
+inline constexpr vk::Format vertex_attribute_format<glm::ivec2> =
+    vk::Format::eR32G32Sint;
 
 class Vertex {
 public:
@@ -1,4 +1,5 @@
 #include "ingame_scene.hpp"
+#include "core/log.hpp"
 #include "glm/gtx/transform.hpp"
 #include "main_menu_scene.hpp"
 
@@ -20,6 +21,12 @@ InGameScene::InGameScene(const core::vulkan::Context &context,
       m_vel_text(context,
                  hodler.get_font(core::ResourceHodler::debug_font_name),
                  L"Velocity"),
+      m_mesh_arena_text(
+          context, hodler.get_font(core::ResourceHodler::debug_font_name),
+          L"Meshes"),
+      m_gpu_text(context,
+                 hodler.get_font(core::ResourceHodler::debug_font_name),
+                 L"GPU"),
       m_player(glm::vec3(128.0f, 70.0f, 128.0f), hodler, m_physics_server),
       m_world(context, m_block_server),
       m_chunk_shader(
@@ -41,6 +48,8 @@ InGameScene::InGameScene(const core::vulkan::Context &context,
 
   m_world.set_center_position(m_player.position);
   m_fog_max_distance = m_world.set_render_distance(settings.render_distance);
+  m_world.set_mesh_mode(settings.greedy_meshing ? chunk::Mesh::Mode::GREEDY
+                                                : chunk::Mesh::Mode::CULLED);
   m_world.start_update_thread();
 
   // Position texts
@@ -51,6 +60,8 @@ InGameScene::InGameScene(const core::vulkan::Context &context,
     m_look_text.set_position(current_pos);
     current_pos.y += m_look_text.get_height() + 10;
     m_vel_text.set_position(current_pos);
+    current_pos.y += m_vel_text.get_height() + 10;
+    m_mesh_arena_text.set_position(current_pos);
   }
 
   // Wait until some chunks have been generated
@@ -140,6 +151,24 @@ std::unique_ptr<scene::Scene> InGameScene::update(core::Window &window,
     fps_stream << L" FPS";
     m_fps_text.set_string(fps_stream.str());
   }
+  if (const auto gpu_profiler{m_context.get_gpu_profiler()};
+      gpu_profiler && !gpu_profiler->get_timings().empty()) {
+    std::wstringstream gpu_stream;
+    gpu_stream << std::fixed << std::setprecision(2);
+    for (const auto &timing : gpu_profiler->get_timings()) {
+      gpu_stream << std::wstring(timing.name.begin(), timing.name.end())
+                 << L": " << timing.milliseconds << L" ms" << std::endl;
+    }
+    m_gpu_text.set_string(gpu_stream.str());
+    // Placed next to the FPS. It has several lines, so it is moved right of
+    // the texts below the FPS as well
+    const auto left_width{std::max(
+        {m_fps_text.get_width(), m_position_text.get_width(),
+         m_look_text.get_width(), m_vel_text.get_width(),
+         m_mesh_arena_text.get_width()})};
+    m_gpu_text.set_position(
+        glm::vec2(static_cast<float>(left_width + 20), 0.0f));
+  }
   {
     constexpr auto float_width = 8;
     std::wstringstream pos_stream;
@@ -179,10 +208,39 @@ std::unique_ptr<scene::Scene> InGameScene::update(core::Window &window,
            << m_player.velocity.z << std::endl;
     m_vel_text.set_string(stream.str());
   }
+  {
+    constexpr auto mebibyte = 1024.0f * 1024.0f;
+    const auto stats(m_world.get_mesh_arena_statistics());
+    std::wstringstream stream;
+    stream << "Meshes" << std::endl;
+    stream << std::fixed << std::setprecision(1);
+    stream << "Used: " << static_cast<float>(stats.used) / mebibyte << "/"
+           << static_cast<float>(stats.capacity) / mebibyte << " MiB"
+           << std::endl;
+    stream << "Buffers: " << stats.buffer_count << std::endl;
+    stream << "Fragmentation: " << stats.fragmentation * 100.0f << "%"
+           << std::endl;
+    const auto [draws, draw_calls] = m_world.get_draw_counts();
+    stream << "Draws: " << draws << " in " << draw_calls << " calls"
+           << std::endl;
+    stream << "Culled: " << m_world.get_culled_count() << std::endl;
+    stream << "Occluded: " << m_world.get_occluded_count() << std::endl;
+    stream << "LOD tiles: " << m_world.get_lod_tile_count() << std::endl;
+    m_mesh_arena_text.set_string(stream.str());
+  }
 
   // Some debug input for testing purposes
   if (window.key_just_pressed(reseed_keyboard_button)) {
     m_world.clear_and_reseed();
+  } else if (window.key_just_pressed(mesh_mode_keyboard_button)) {
+    // Switch between culled and greedy meshing to compare them
+    const auto mode{m_world.get_mesh_mode() == chunk::Mesh::Mode::CULLED
+                        ? chunk::Mesh::Mode::GREEDY
+                        : chunk::Mesh::Mode::CULLED};
+    core::Log::info(std::string("Switching to ") +
+                    (mode == chunk::Mesh::Mode::GREEDY ? "greedy" : "culled") +
+                    " meshing");
+    m_world.set_mesh_mode(mode);
   } else if (window.key_just_pressed(place_player_keyboard_button)) {
     // Place player at the correct height at the current position
     if (const auto player_height(m_world.get_height(m_player.position));
@@ -200,7 +258,9 @@ std::unique_ptr<scene::Scene> InGameScene::update(core::Window &window,
       m_selected_position.reset();
     }
   }
-  m_world.set_center_position(m_player.position);
+  m_world.set_center_position(m_player.position,
+                              m_player.get_look_direction(),
+                              m_player.velocity);
 
   m_physics_server.update(m_world, delta_time);
 
@@ -222,26 +282,41 @@ void InGameScene::render(const core::vulkan::RenderCall &render_call,
   }
 
   // Render the world
-  m_chunk_shader.bind(render_call);
-  // fog max distance
-  m_chunk_shader.set_push_constant(render_call, m_fog_max_distance);
-  m_world.render(render_call);
+  {
+    const auto gpu_scope(render_call.begin_gpu_scope("chunks"));
+    m_chunk_shader.bind(render_call);
+    // fog max distance
+    m_chunk_shader.set_push_constant(render_call, m_fog_max_distance);
+    m_world.render(render_call, m_chunk_global.proj_view,
+                   m_chunk_global.eye_pos);
+  }
 
   // Render selected block
   if (m_selected_position) {
+    const auto gpu_scope(render_call.begin_gpu_scope("lines"));
     core::Line3D::bind_shader(render_call);
     m_selected_block.set_model_matrix(*m_selected_position);
     m_selected_block.render(render_call);
   }
 
   // Render the player
-  core::Render2D::bind_shader(render_call);
-  m_player.render(render_call);
+  {
+    const auto gpu_scope(render_call.begin_gpu_scope("2d"));
+    core::Render2D::bind_shader(render_call);
+    m_player.render(render_call);
+  }
 
   // Render the text elements
-  core::text::Text::bind_shader(render_call);
-  m_fps_text.render(render_call);
-  m_position_text.render(render_call);
-  m_look_text.render(render_call);
-  m_vel_text.render(render_call);
+  {
+    const auto gpu_scope(render_call.begin_gpu_scope("text"));
+    core::text::Text::bind_shader(render_call);
+    m_fps_text.render(render_call);
+    m_position_text.render(render_call);
+    m_look_text.render(render_call);
+    m_vel_text.render(render_call);
+    m_mesh_arena_text.render(render_call);
+    if (m_context.get_gpu_profiler()) {
+      m_gpu_text.render(render_call);
+    }
+  }
 }
\ No newline at end of file
@@ -25,6 +25,7 @@ public:
               const float delta_time) override;
 
 private:
+  static constexpr int mesh_mode_keyboard_button = GLFW_KEY_F7;
   static constexpr int reseed_keyboard_button = GLFW_KEY_F8;
   static constexpr int place_player_keyboard_button = GLFW_KEY_F9;
   static constexpr int back_keyboard_button = GLFW_KEY_ESCAPE;
@@ -37,6 +38,9 @@ private:
   core::text::Text m_position_text;
   core::text::Text m_look_text;
   core::text::Text m_vel_text;
+  core::text::Text m_mesh_arena_text;
+  // Shows the GPU timings if GPU profiling is enabled
+  core::text::Text m_gpu_text;
 
   Player m_player;
   chunk::World m_world;
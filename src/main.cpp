@@ -3,6 +3,7 @@
 #include "core/fps_timer.hpp"
 #include "core/line_3d.hpp"
 #include "core/log.hpp"
+#include "core/profiler.hpp"
 #include "core/settings.hpp"
 #include "core/text/font.hpp"
 #include "core/text/text.hpp"
@@ -15,8 +16,24 @@
 #include <sstream>
 
 static constexpr int fullscreen_keyboard_button = GLFW_KEY_F11;
+#ifdef VULKANKRAFT_PROFILER
+static constexpr int profiler_export_keyboard_button = GLFW_KEY_F10;
+static constexpr char profiler_trace_file_name[] = "profiler_trace.json";
+
+// Writes the recorded profiler zones into the settings folder
+static void export_profiler_trace(const core::Settings &settings) {
+  const auto file_name(settings.settings_folder / profiler_trace_file_name);
+  try {
+    core::Profiler::export_trace(file_name);
+    core::Log::info("exported profiler trace to " + file_name.string());
+  } catch (const core::VulkanKraftException &e) {
+    core::Log::warning(e.what());
+  }
+}
+#endif
 
 int main(int args, char *argv[]) {
+  VULKANKRAFT_PROFILE_THREAD("main");
   // Initialise all objects not requireing vulkan directly
   core::Settings settings;
   core::FPSTimer timer(settings.max_fps);
@@ -35,8 +52,6 @@ int main(int args, char *argv[]) {
     core::ResourceHodler hodler(context, settings);
 
     // Retrieve the shaders from the resource hodler
-    auto &chunk_shader =
-        hodler.get_shader(core::ResourceHodler::chunk_mesh_shader_name);
     auto &text_shader =
         hodler.get_shader(core::ResourceHodler::text_shader_name);
     auto &texture_2d_shader =
@@ -60,6 +75,11 @@ int main(int args, char *argv[]) {
       if (window.key_just_pressed(fullscreen_keyboard_button)) {
         window.toggle_fullscreen();
       }
+#ifdef VULKANKRAFT_PROFILER
+      if (window.key_just_pressed(profiler_export_keyboard_button)) {
+        export_profiler_trace(settings);
+      }
+#endif
 
       {
         auto switch_scene(
@@ -97,5 +117,9 @@ int main(int args, char *argv[]) {
     core::Log::error(e.what());
   }
 
+#ifdef VULKANKRAFT_PROFILER
+  export_profiler_trace(settings);
+#endif
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "frustum.hpp"
+
+namespace physics {
+Frustum::Frustum(const glm::mat4 &proj_view) {
+  // The planes are the sums and differences of the fourth row with the other
+  // rows. glm stores the matrix by columns
+  const auto row = [&](const int i) {
+    return glm::vec4(proj_view[0][i], proj_view[1][i], proj_view[2][i],
+                     proj_view[3][i]);
+  };
+  const auto r3{row(3)};
+  const std::array<glm::vec4, plane_count> planes{
+      r3 + row(0), r3 - row(0), r3 + row(1),
+      r3 - row(1), r3 + row(2), r3 - row(2),
+  };
+
+  for (size_t i = 0; i < plane_count; i++) {
+    // Normalized so that the distances are measured in blocks
+    const auto p{planes[i] / glm::length(glm::vec3(planes[i]))};
+    m_a[i] = p.x;
+    m_b[i] = p.y;
+    m_c[i] = p.z;
+    m_d[i] = p.w;
+  }
+}
+
+bool Frustum::intersects(const AABB &aabb) const {
+  uint8_t visible;
+  intersects(&aabb, 1, &visible);
+  return visible != 0;
+}
+
+void Frustum::intersects(const AABB *aabbs, const size_t count,
+                         uint8_t *visible) const {
+  for (size_t i = 0; i < count; i++) {
+    visible[i] = 1;
+  }
+
+  // Only the corner which lies the furthest along the normal of a plane needs
+  // to be tested. If it lies behind the plane the whole box does too
+  for (size_t p = 0; p < plane_count; p++) {
+    const auto a{m_a[p]}, b{m_b[p]}, c{m_c[p]}, d{m_d[p]};
+    const auto take_x{a >= 0.0f ? 1.0f : 0.0f};
+    const auto take_y{b >= 0.0f ? 1.0f : 0.0f};
+    const auto take_z{c >= 0.0f ? 1.0f : 0.0f};
+
+    for (size_t i = 0; i < count; i++) {
+      const auto &pos{aabbs[i].position};
+      const auto &dim{aabbs[i].dimensions};
+      const auto x{pos.x + dim.x * take_x};
+      const auto y{pos.y + dim.y * take_y};
+      const auto z{pos.z + dim.z * take_z};
+      visible[i] &= static_cast<uint8_t>(a * x + b * y + c * z + d >= 0.0f);
+    }
+  }
+}
+} // namespace physics
@@ -0,0 +1,31 @@
+#pragma once
+#include "aabb.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace physics {
+// The view frustum of a camera. The planes are extracted from a projection
+// view matrix and stored as structure of arrays so that the boxes can be
+// tested against all planes in tight loops the compiler can vectorize
+class Frustum {
+public:
+  static constexpr size_t plane_count = 6;
+
+  Frustum(const glm::mat4 &proj_view);
+
+  // Returns wether aabb is at least partially inside of the frustum
+  bool intersects(const AABB &aabb) const;
+  // Tests count boxes at once and writes 1 into visible for every box which is
+  // at least partially inside of the frustum and 0 otherwise
+  void intersects(const AABB *aabbs, const size_t count,
+                  uint8_t *visible) const;
+
+private:
+  // The planes point inwards: a*x + b*y + c*z + d >= 0 is inside
+  std::array<float, plane_count> m_a;
+  std::array<float, plane_count> m_b;
+  std::array<float, plane_count> m_c;
+  std::array<float, plane_count> m_d;
+};
+} // namespace physics
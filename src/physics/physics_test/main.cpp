@@ -1,6 +1,9 @@
 #include "../../core/math.hpp"
 #include "../aabb.hpp"
+#include "../frustum.hpp"
+#include <array>
 #include <cassert>
+#include <glm/gtc/matrix_transform.hpp>
 
 inline bool almost(const float v1, const float v2) {
   return core::math::abs(v1 - v2) < 1e-5;
@@ -26,5 +29,50 @@ int main(int args, char *argv[]) {
   assert(almost(y, 0.0f));
   assert(almost(z, -0.2f));
 
+  // The planes of an orthographic frustum looking down the negative z axis.
+  // Every plane has a box just outside and a box crossing it
+  const physics::Frustum ortho(glm::ortho(-10.0f, 10.0f, -5.0f, 5.0f, 1.0f,
+                                          100.0f));
+  assert(ortho.intersects(physics::AABB(-0.5f, -0.5f, -50.5f, 1, 1, 1)));
+  assert(!ortho.intersects(physics::AABB(10.5f, 0.0f, -50.0f, 1, 1, 1)));
+  assert(ortho.intersects(physics::AABB(9.5f, 0.0f, -50.0f, 1, 1, 1)));
+  assert(!ortho.intersects(physics::AABB(-11.5f, 0.0f, -50.0f, 1, 1, 1)));
+  assert(ortho.intersects(physics::AABB(-10.5f, 0.0f, -50.0f, 1, 1, 1)));
+  assert(!ortho.intersects(physics::AABB(0.0f, 5.5f, -50.0f, 1, 1, 1)));
+  assert(ortho.intersects(physics::AABB(0.0f, 4.5f, -50.0f, 1, 1, 1)));
+  assert(!ortho.intersects(physics::AABB(0.0f, -6.5f, -50.0f, 1, 1, 1)));
+  assert(ortho.intersects(physics::AABB(0.0f, -5.5f, -50.0f, 1, 1, 1)));
+  assert(!ortho.intersects(physics::AABB(0.0f, 0.0f, -0.5f, 1, 1, 1)));
+  assert(ortho.intersects(physics::AABB(0.0f, 0.0f, -1.5f, 1, 1, 1)));
+  assert(!ortho.intersects(physics::AABB(0.0f, 0.0f, -101.5f, 1, 1, 1)));
+  assert(ortho.intersects(physics::AABB(0.0f, 0.0f, -100.5f, 1, 1, 1)));
+  // A box larger than the frustum contains it
+  assert(ortho.intersects(
+      physics::AABB(-50.0f, -50.0f, -200.0f, 100.0f, 100.0f, 300.0f)));
+
+  // A perspective camera at the origin looking along the positive x axis
+  // with a field of view of 90 degrees
+  const physics::Frustum perspective(
+      glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f) *
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f)));
+  const std::array<physics::AABB, 6> boxes{
+      physics::AABB(10.0f, -0.5f, -0.5f, 1, 1, 1),
+      physics::AABB(-11.0f, -0.5f, -0.5f, 1, 1, 1),
+      physics::AABB(10.0f, -0.5f, 20.0f, 1, 1, 1),
+      physics::AABB(10.0f, -0.5f, 8.0f, 1, 1, 1),
+      physics::AABB(10.0f, -20.0f, -0.5f, 1, 1, 1),
+      physics::AABB(1100.0f, -0.5f, -0.5f, 1, 1, 1),
+  };
+  constexpr std::array<uint8_t, 6> expected{1, 0, 0, 1, 0, 0};
+
+  // Testing the boxes at once gives the same results as testing each box
+  std::array<uint8_t, 6> visible;
+  perspective.intersects(boxes.data(), boxes.size(), visible.data());
+  for (size_t i = 0; i < boxes.size(); i++) {
+    assert(visible[i] == expected[i]);
+    assert(perspective.intersects(boxes[i]) == (expected[i] != 0));
+  }
+
   return 0;
 }
\ No newline at end of file
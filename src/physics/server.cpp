@@ -1,5 +1,6 @@
 #include "server.hpp"
 #include "../core/math.hpp"
+#include "../core/profiler.hpp"
 #include "moving_object.hpp"
 #include <cmath>
 
@@ -9,6 +10,7 @@ Server::Server(const float desired_delta_time)
     : m_desired_delta_time(desired_delta_time), m_elapsed_time(0.0f) {}
 
 void Server::update(const chunk::World &world, const float delta_time) {
+  VULKANKRAFT_PROFILE_ZONE("physics::Server::update");
   m_elapsed_time += delta_time;
 
   // NOTE: The physics are blocked for the first three second to fix the falling
@@ -43,7 +45,8 @@ void Server::_update(const chunk::World &world, const float delta_time) {
 void Server::_check_aabb(const chunk::World &world, MovingObject *mob) const {
   // Get the chunks in which the AABB resides
   const auto chunk_pos(chunk::World::get_chunk_position(mob->m_aabb.position));
-  if (world.m_chunks.find(chunk_pos) == world.m_chunks.end()) {
+  const auto *center_chunk{world.m_chunks.find(chunk_pos)};
+  if (!center_chunk) {
     // There is no chunk at the position of the AABB
     return;
   }
@@ -52,7 +55,7 @@ void Server::_check_aabb(const chunk::World &world, MovingObject *mob) const {
   colliding_chunks.reserve(9);
 
   // Get the chunk and all its eight neighbors
-  const auto chunk(world.m_chunks.at(chunk_pos));
+  const auto chunk(*center_chunk);
   if (auto chunk_aabb(chunk->to_aabb()); chunk_aabb.collide(mob->m_aabb)) {
     colliding_chunks.push_back(chunk);
   }
@@ -116,9 +119,22 @@ void Server::_check_aabb(const chunk::World &world, MovingObject *mob) const {
     // Loop over all blocks
     for (size_t x = 0; x < chunk::block_width; x++) {
       for (size_t y = 0; y < chunk::block_height; y++) {
+        // Sections which only contain air can't collide
+        const auto &section{cc->get_section_at(y)};
+        if (section.is_empty()) {
+          y += chunk::section_height - 1 - y % chunk::section_height;
+          continue;
+        }
+
         for (size_t z = 0; z < chunk::block_depth; z++) {
-          const auto &block{cc->get_block(x, y, z)};
-          if (block::Server::block_is_solid(block.type)) {
+          // The inner blocks of a full section have no faces and therefore
+          // can't push the AABB
+          if (section.is_full() && chunk::is_inner_section_block(x, y, z)) {
+            continue;
+          }
+
+          if (block::Server::block_is_solid(cc->get(x, y, z))) {
+            const auto &block{cc->get_block(x, y, z)};
             // Push the AABB if it collides with the block
             const auto block_aabb(block.to_aabb(
                 glm::vec3(static_cast<float>(x) +
@@ -44,6 +44,7 @@ World::World(const std::filesystem::path &folder) : m_folder(folder) {
 std::optional<std::array<uint8_t, chunk::block_width * chunk::block_depth *
                                       chunk::block_height>>
 World::load_chunk(const std::pair<int, int> &chunk_position) const {
+  std::shared_lock lk(m_chunk_files_mutex);
   if (m_chunk_file_names.find(chunk_position) == m_chunk_file_names.end()) {
     return std::nullopt;
   }
@@ -69,6 +70,7 @@ void World::store_chunk(
     const std::pair<int, int> &chunk_position,
     const std::array<uint8_t, chunk::block_width * chunk::block_depth *
                                   chunk::block_height> &block_array) {
+  std::lock_guard lk(m_chunk_files_mutex);
   std::filesystem::path file_name;
   if (m_chunk_file_names.find(chunk_position) != m_chunk_file_names.end()) {
     file_name = m_chunk_file_names.at(chunk_position);
@@ -5,6 +5,7 @@
 #include <glm/glm.hpp>
 #include <map>
 #include <optional>
+#include <shared_mutex>
 
 namespace save {
 class World {
@@ -20,6 +21,8 @@ public:
 
   World(const std::filesystem::path &folder);
 
+  // Chunks can be loaded by multiple threads while another thread stores
+  // chunks
   std::optional<std::array<uint8_t, chunk::block_width * chunk::block_depth *
                                         chunk::block_height>>
   load_chunk(const std::pair<int, int> &chunk_position) const;
@@ -35,6 +38,8 @@ public:
 private:
   // Stores all file names of all available chunks in the save folder
   std::map<std::pair<int, int>, std::filesystem::path> m_chunk_file_names;
+  // Guards m_chunk_file_names and the chunk files
+  mutable std::shared_mutex m_chunk_files_mutex;
   // The file name of the file storing meta data about the world
   std::filesystem::path m_meta_data_file_name;
   // The file name of the file storing all player data about the world
@@ -0,0 +1,106 @@
+#include "noise_cache.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace world_gen {
+namespace {
+// Divides v by region_size and rounds towards negative infinity
+inline int to_region(const int v) {
+  return v >= 0 ? v / NoiseCache::region_size
+                : (v + 1) / NoiseCache::region_size - 1;
+}
+} // namespace
+
+NoiseCache::NoiseCache(const size_t capacity)
+    : m_capacity(capacity), m_next_id(0), m_hits(0), m_misses(0) {}
+
+void NoiseCache::get_grid(const size_t seed, const uint32_t layer,
+                          const glm::ivec2 &origin, const size_t width,
+                          const size_t height, float *values,
+                          const Generator &generator) {
+  const glm::ivec2 end(origin.x + static_cast<int>(width),
+                       origin.y + static_cast<int>(height));
+
+  // Copies the part of every region which overlaps the grid
+  for (int region_z = to_region(origin.y); region_z <= to_region(end.y - 1);
+       region_z++) {
+    for (int region_x = to_region(origin.x); region_x <= to_region(end.x - 1);
+         region_x++) {
+      const glm::ivec2 region_origin(region_x * region_size,
+                                     region_z * region_size);
+      const auto region{_get_region(
+          Key{seed, layer, glm::ivec2(region_x, region_z)}, generator)};
+
+      const auto from{glm::max(origin, region_origin)};
+      const auto to{glm::min(end, region_origin + glm::ivec2(region_size))};
+      for (int z = from.y; z < to.y; z++) {
+        std::memcpy(
+            &values[(from.x - origin.x) + (z - origin.y) * width],
+            &(*region)[(from.x - region_origin.x) +
+                       (z - region_origin.y) * region_size],
+            sizeof(float) * (to.x - from.x));
+      }
+    }
+  }
+}
+
+void NoiseCache::clear() {
+  std::lock_guard lk(m_mutex);
+  m_regions.clear();
+  m_lookup.clear();
+  m_hits = 0;
+  m_misses = 0;
+}
+
+NoiseCache::Statistics NoiseCache::get_statistics() const {
+  return Statistics{m_hits, m_misses};
+}
+
+std::shared_ptr<const NoiseCache::Region>
+NoiseCache::_get_region(const Key &key, const Generator &generator) {
+  std::promise<std::shared_ptr<const Region>> promise;
+  std::shared_future<std::shared_ptr<const Region>> stored_region;
+  uint64_t id{0};
+  {
+    std::lock_guard lk(m_mutex);
+    if (const auto entry{m_lookup.find(key)}; entry != m_lookup.end()) {
+      m_regions.splice(m_regions.begin(), m_regions, entry->second);
+      m_hits++;
+      stored_region = entry->second->region;
+    } else {
+      m_misses++;
+      id = m_next_id++;
+      m_regions.emplace_front(Entry{key, promise.get_future().share(), id});
+      m_lookup.emplace(key, m_regions.begin());
+      if (m_regions.size() > m_capacity) {
+        m_lookup.erase(m_regions.back().key);
+        m_regions.pop_back();
+      }
+    }
+  }
+  if (stored_region.valid()) {
+    return stored_region.get();
+  }
+
+  // The region is generated without the mutex being locked so that the other
+  // threads are not blocked
+  auto region{std::make_shared<Region>()};
+  try {
+    generator(key.position * region_size, region->data());
+  } catch (...) {
+    {
+      // The entry could already have been dropped or replaced
+      std::lock_guard lk(m_mutex);
+      if (const auto entry{m_lookup.find(key)};
+          entry != m_lookup.end() && entry->second->id == id) {
+        m_regions.erase(entry->second);
+        m_lookup.erase(entry);
+      }
+    }
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+  promise.set_value(region);
+  return region;
+}
+} // namespace world_gen
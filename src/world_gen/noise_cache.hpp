@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <glm/glm.hpp>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace world_gen {
+// Caches the 2D noise values of square regions of columns. Neighbouring
+// chunks lie in the same region, so the noise of a region is only computed
+// once. The regions are identified by the seed, the noise layer and the
+// position. The least recently used regions are dropped once more than
+// capacity regions are stored. It can be used by multiple threads at once.
+// Threads which need a region that is currently generated by another thread
+// wait for it instead of generating it again
+class NoiseCache {
+public:
+  // The width and depth of a region in columns
+  static constexpr int region_size = 64;
+  // How many regions are stored by default. Covers the chunks and the far
+  // terrain of the highest render distance
+  static constexpr size_t default_capacity = 1024;
+
+  // Writes the noise values of the region_size * region_size columns starting
+  // at origin into values. The value of origin + (x, z) is written into
+  // values[x + z * region_size]
+  using Generator =
+      std::function<void(const glm::ivec2 &origin, float *values)>;
+
+  // How often the regions have been found and how often they had to be
+  // generated
+  struct Statistics {
+    uint64_t hits;
+    uint64_t misses;
+
+    inline float get_hit_rate() const {
+      return hits + misses == 0 ? 0.0f
+                                : static_cast<float>(hits) /
+                                      static_cast<float>(hits + misses);
+    }
+  };
+
+  NoiseCache(const size_t capacity = default_capacity);
+
+  // Writes the noise values of layer of width * height columns starting at
+  // origin into values. The value of origin + (x, z) is written into
+  // values[x + z * width]. The regions which are not stored yet are generated
+  // with generator
+  void get_grid(const size_t seed, const uint32_t layer,
+                const glm::ivec2 &origin, const size_t width,
+                const size_t height, float *values,
+                const Generator &generator);
+  // Removes all regions and resets the statistics
+  void clear();
+
+  Statistics get_statistics() const;
+
+private:
+  using Region = std::array<float, region_size * region_size>;
+
+  struct Key {
+    size_t seed;
+    uint32_t layer;
+    glm::ivec2 position;
+
+    inline bool operator==(const Key &other) const {
+      return seed == other.seed && layer == other.layer &&
+             position == other.position;
+    }
+  };
+
+  struct KeyHash {
+    inline size_t operator()(const Key &key) const {
+      auto hash{static_cast<uint64_t>(key.seed)};
+      hash = hash * 31 + key.layer;
+      hash = hash * 31 + static_cast<uint32_t>(key.position.x);
+      hash = hash * 31 + static_cast<uint32_t>(key.position.y);
+      return static_cast<size_t>(hash * 0x9E3779B97F4A7C15ull);
+    }
+  };
+
+  struct Entry {
+    Key key;
+    // The region is ready once the thread generating it has finished
+    std::shared_future<std::shared_ptr<const Region>> region;
+    // Identifies the entry since another entry of the same key can replace it
+    // while it is generated
+    uint64_t id;
+  };
+
+  // Returns the region of key and generates it if it is not stored. If
+  // generator throws the entry is removed again, so that the next call
+  // retries, and the exception is passed on to the caller and to the threads
+  // waiting for the region
+  std::shared_ptr<const Region> _get_region(const Key &key,
+                                            const Generator &generator);
+
+  // The regions with the most recently used first
+  std::list<Entry> m_regions;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_lookup;
+  const size_t m_capacity;
+  // The id of the next entry. Guarded by m_mutex
+  uint64_t m_next_id;
+  mutable std::mutex m_mutex;
+
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+} // namespace world_gen
@@ -3,13 +3,133 @@
 #include <algorithm>
 #include <cmath>
 #include <random>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VULKANKRAFT_PERLIN_SIMD
+#elif defined(__SSE2__) || defined(_M_X64) ||                                 \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VULKANKRAFT_PERLIN_SIMD
+#endif
 
 namespace world_gen {
+#ifdef VULKANKRAFT_PERLIN_SIMD
+namespace {
+// Thin wrappers around the intrinsics so that the batched noise is written
+// only once for every instruction set
+namespace simd {
+#if defined(__AVX2__)
+constexpr size_t lane_count = 8;
+using Floats = __m256;
+using Ints = __m256i;
+
+inline Floats set(const float v) { return _mm256_set1_ps(v); }
+inline Ints set(const int32_t v) { return _mm256_set1_epi32(v); }
+inline Floats load(const float *v) { return _mm256_loadu_ps(v); }
+inline void store(float *v, const Floats a) { _mm256_storeu_ps(v, a); }
+inline Floats add(const Floats a, const Floats b) {
+  return _mm256_add_ps(a, b);
+}
+inline Floats sub(const Floats a, const Floats b) {
+  return _mm256_sub_ps(a, b);
+}
+inline Floats mul(const Floats a, const Floats b) {
+  return _mm256_mul_ps(a, b);
+}
+inline Ints add(const Ints a, const Ints b) { return _mm256_add_epi32(a, b); }
+inline Ints bit_and(const Ints a, const Ints b) {
+  return _mm256_and_si256(a, b);
+}
+inline Floats bit_xor(const Floats a, const Ints b) {
+  return _mm256_xor_ps(a, _mm256_castsi256_ps(b));
+}
+inline Floats clear_sign(const Floats a) {
+  return _mm256_andnot_ps(set(-0.0f), a);
+}
+// Moves bit 1 of every lane into the sign bit
+inline Ints to_sign(const Ints a) {
+  return _mm256_slli_epi32(_mm256_and_si256(a, set(2)), 30);
+}
+inline Ints truncate(const Floats a) { return _mm256_cvttps_epi32(a); }
+inline Floats to_float(const Ints a) { return _mm256_cvtepi32_ps(a); }
+// Returns wether any lane of a or b equals v
+inline bool any_equal(const Ints a, const Ints b, const int32_t v) {
+  const auto equal{_mm256_or_si256(_mm256_cmpeq_epi32(a, set(v)),
+                                   _mm256_cmpeq_epi32(b, set(v)))};
+  return _mm256_movemask_epi8(equal) != 0;
+}
+inline Ints gather(const int32_t *table, const Ints indices) {
+  return _mm256_i32gather_epi32(table, indices, 4);
+}
+#else
+constexpr size_t lane_count = 4;
+using Floats = __m128;
+using Ints = __m128i;
+
+inline Floats set(const float v) { return _mm_set1_ps(v); }
+inline Ints set(const int32_t v) { return _mm_set1_epi32(v); }
+inline Floats load(const float *v) { return _mm_loadu_ps(v); }
+inline void store(float *v, const Floats a) { _mm_storeu_ps(v, a); }
+inline Floats add(const Floats a, const Floats b) { return _mm_add_ps(a, b); }
+inline Floats sub(const Floats a, const Floats b) { return _mm_sub_ps(a, b); }
+inline Floats mul(const Floats a, const Floats b) { return _mm_mul_ps(a, b); }
+inline Ints add(const Ints a, const Ints b) { return _mm_add_epi32(a, b); }
+inline Ints bit_and(const Ints a, const Ints b) { return _mm_and_si128(a, b); }
+inline Floats bit_xor(const Floats a, const Ints b) {
+  return _mm_xor_ps(a, _mm_castsi128_ps(b));
+}
+inline Floats clear_sign(const Floats a) {
+  return _mm_andnot_ps(set(-0.0f), a);
+}
+// Moves bit 1 of every lane into the sign bit
+inline Ints to_sign(const Ints a) {
+  return _mm_slli_epi32(_mm_and_si128(a, set(2)), 30);
+}
+inline Ints truncate(const Floats a) { return _mm_cvttps_epi32(a); }
+inline Floats to_float(const Ints a) { return _mm_cvtepi32_ps(a); }
+// Returns wether any lane of a or b equals v
+inline bool any_equal(const Ints a, const Ints b, const int32_t v) {
+  const auto equal{
+      _mm_or_si128(_mm_cmpeq_epi32(a, set(v)), _mm_cmpeq_epi32(b, set(v)))};
+  return _mm_movemask_epi8(equal) != 0;
+}
+// SSE2 has no gather instruction, so the lanes are looked up one by one
+inline Ints gather(const int32_t *table, const Ints indices) {
+  alignas(16) int32_t i[lane_count];
+  _mm_store_si128(reinterpret_cast<__m128i *>(i), indices);
+  return _mm_setr_epi32(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+}
+#endif
+
+// Returns the dot product of (x, y) with the gradient selected by h. The
+// gradients only consist of 1 and -1, so the multiplication is replaced by
+// flipping the sign
+inline Floats dot_gradient(const Ints h, const Floats x, const Floats y) {
+  // h: 0 --> (1, 1); 1 --> (-1, 1); 2 --> (-1, -1); 3 --> (1, -1)
+  return add(bit_xor(x, to_sign(add(h, set(1)))), bit_xor(y, to_sign(h)));
+}
+
+inline Floats fade(const Floats t) {
+  return mul(
+      mul(mul(add(mul(sub(mul(set(6.0f), t), set(15.0f)), t), set(10.0f)), t),
+          t),
+      t);
+}
+
+inline Floats lerp(const Floats t, const Floats a1, const Floats a2) {
+  return add(a1, mul(t, sub(a2, a1)));
+}
+} // namespace simd
+} // namespace
+#endif
+
 PerlinNoise::PerlinNoise() { seed(1); }
 
 void PerlinNoise::seed(const size_t seed) {
   for (size_t i = 0; i < noise_size; i++) {
-    m_p[i] = i;
+    m_p[i] = static_cast<int32_t>(i);
   }
 
   std::mt19937_64 random_engine;
@@ -17,6 +137,10 @@ void PerlinNoise::seed(const size_t seed) {
 
   std::shuffle(m_p.begin(), m_p.end() - 1, random_engine);
   m_p.back() = m_p[noise_size - 1];
+
+  for (size_t i = 0; i < m_gradients.size(); i++) {
+    m_gradients[i] = m_p[i % (noise_size + 1)] % 4;
+  }
 }
 
 float PerlinNoise::get(const float x, const float y, const float _freq,
@@ -36,6 +160,116 @@ float PerlinNoise::get(const float x, const float y, const float _freq,
   return _clamp(sum, -1.0f, 1.0f);
 }
 
+void PerlinNoise::get_grid(const glm::ivec2 &origin, const size_t width,
+                           const size_t height, float *values,
+                           const float freq, const int oct) const {
+  for (size_t j = 0; j < height; j++) {
+    const auto y{static_cast<float>(origin.y + static_cast<int>(j))};
+    auto *row{values + j * width};
+
+    size_t i{0};
+#ifdef VULKANKRAFT_PERLIN_SIMD
+    for (; i + simd::lane_count <= width; i += simd::lane_count) {
+      std::array<float, simd::lane_count> xs, ys;
+      for (size_t l = 0; l < simd::lane_count; l++) {
+        xs[l] = static_cast<float>(origin.x + static_cast<int>(i + l));
+        ys[l] = y;
+      }
+
+      if (!_get_batch(xs.data(), ys.data(), row + i, freq, oct)) {
+        for (size_t l = 0; l < simd::lane_count; l++) {
+          row[i + l] = get(xs[l], y, freq, oct);
+        }
+      }
+    }
+#endif
+    for (; i < width; i++) {
+      row[i] = get(static_cast<float>(origin.x + static_cast<int>(i)), y,
+                   freq, oct);
+    }
+  }
+}
+
+float PerlinNoise::get_3d(const float x, const float y, const float z,
+                          const float _freq, const int oct) const {
+  float sum{0.0f};
+  float freq{_freq};
+  float amp{1.0f};
+
+  for (int i = 0; i < oct; i++) {
+    sum += _get_3d(x, y, z, freq) * amp;
+    freq *= 2.0f;
+    amp /= 2.0f;
+  }
+
+  return _clamp(sum, -1.0f, 1.0f);
+}
+
+void PerlinNoise::get_interpolated_grid(const glm::ivec3 &origin,
+                                        const glm::ivec3 &size,
+                                        const glm::ivec3 &cell_size,
+                                        float *values, const float freq,
+                                        const int oct) const {
+#ifndef NDEBUG
+  assert(size.x % cell_size.x == 0);
+  assert(size.y % cell_size.y == 0);
+  assert(size.z % cell_size.z == 0);
+#endif
+
+  // The noise at the corners of all cells
+  const auto lattice_size{size / cell_size + 1};
+  std::vector<float> lattice(lattice_size.x * lattice_size.y *
+                             lattice_size.z);
+  const auto lattice_at{[&](const int x, const int y, const int z) -> float & {
+    return lattice[x + (z + y * lattice_size.z) * lattice_size.x];
+  }};
+  for (int y = 0; y < lattice_size.y; y++) {
+    for (int z = 0; z < lattice_size.z; z++) {
+      for (int x = 0; x < lattice_size.x; x++) {
+        const auto position{origin + glm::ivec3(x, y, z) * cell_size};
+        lattice_at(x, y, z) =
+            get_3d(static_cast<float>(position.x),
+                   static_cast<float>(position.y),
+                   static_cast<float>(position.z), freq, oct);
+      }
+    }
+  }
+
+  for (int y = 0; y < size.y; y++) {
+    const auto cell_y{y / cell_size.y};
+    const auto t_y{static_cast<float>(y % cell_size.y) /
+                   static_cast<float>(cell_size.y)};
+    for (int z = 0; z < size.z; z++) {
+      const auto cell_z{z / cell_size.z};
+      const auto t_z{static_cast<float>(z % cell_size.z) /
+                     static_cast<float>(cell_size.z)};
+      // The edges of the cells along x are interpolated once per row. The
+      // right edge of a cell is the left edge of the next one
+      auto left{_lerp(
+          t_y,
+          _lerp(t_z, lattice_at(0, cell_y, cell_z),
+                lattice_at(0, cell_y, cell_z + 1)),
+          _lerp(t_z, lattice_at(0, cell_y + 1, cell_z),
+                lattice_at(0, cell_y + 1, cell_z + 1)))};
+      auto *row{values + (z + y * size.z) * size.x};
+      for (int cell_x = 0; cell_x < size.x / cell_size.x; cell_x++) {
+        const auto right{_lerp(
+            t_y,
+            _lerp(t_z, lattice_at(cell_x + 1, cell_y, cell_z),
+                  lattice_at(cell_x + 1, cell_y, cell_z + 1)),
+            _lerp(t_z, lattice_at(cell_x + 1, cell_y + 1, cell_z),
+                  lattice_at(cell_x + 1, cell_y + 1, cell_z + 1)))};
+        for (int x = 0; x < cell_size.x; x++) {
+          row[cell_x * cell_size.x + x] =
+              _lerp(static_cast<float>(x) / static_cast<float>(cell_size.x),
+                    left, right);
+        }
+        left = right;
+      }
+    }
+  }
+}
+
 float PerlinNoise::_get(float x, float y, const float freq) const {
   x = core::math::abs(x + noise_offset);
   y = core::math::abs(y + noise_offset);
@@ -77,4 +311,117 @@ float PerlinNoise::_get(float x, float y, const float freq) const {
   return result;
 }
 
+float PerlinNoise::_get_3d(float x, float y, float z, const float freq) const {
+  x = core::math::abs(x + noise_offset);
+  y = core::math::abs(y + noise_offset);
+  z = core::math::abs(z + noise_offset);
+  x *= freq;
+  y *= freq;
+  z *= freq;
+
+  const auto X{static_cast<size_t>(floorf(x)) % noise_size};
+  const auto Y{static_cast<size_t>(floorf(y)) % noise_size};
+  const auto Z{static_cast<size_t>(floorf(z)) % noise_size};
+  const auto xf{x - floorf(x)};
+  const auto yf{y - floorf(y)};
+  const auto zf{z - floorf(z)};
+
+  // The hashes of the corners are
+  // m_p[(m_p[(m_p[X + dx] + Y + dy) % (noise_size + 1)] + Z + dz) %
+  // (noise_size + 1)]. The inner lookups are shared by multiple corners
+  constexpr auto p_size{noise_size + 1};
+  const auto x0{m_p[X] + Y}, x1{m_p[X + 1] + Y};
+  const auto x0y0{m_p[x0 % p_size] + Z}, x0y1{m_p[(x0 + 1) % p_size] + Z};
+  const auto x1y0{m_p[x1 % p_size] + Z}, x1y1{m_p[(x1 + 1) % p_size] + Z};
+
+  const auto u{_fade(xf)};
+  const auto v{_fade(yf)};
+  const auto w{_fade(zf)};
+  const auto front{_lerp(
+      v,
+      _lerp(u, _dot_constant_vector_3d(m_p[x0y0 % p_size], xf, yf, zf),
+            _dot_constant_vector_3d(m_p[x1y0 % p_size], xf - 1.0f, yf, zf)),
+      _lerp(u,
+            _dot_constant_vector_3d(m_p[x0y1 % p_size], xf, yf - 1.0f, zf),
+            _dot_constant_vector_3d(m_p[x1y1 % p_size], xf - 1.0f,
+                                    yf - 1.0f, zf)))};
+  const auto back{_lerp(
+      v,
+      _lerp(u,
+            _dot_constant_vector_3d(m_p[(x0y0 + 1) % p_size], xf, yf,
+                                    zf - 1.0f),
+            _dot_constant_vector_3d(m_p[(x1y0 + 1) % p_size], xf - 1.0f, yf,
+                                    zf - 1.0f)),
+      _lerp(u,
+            _dot_constant_vector_3d(m_p[(x0y1 + 1) % p_size], xf, yf - 1.0f,
+                                    zf - 1.0f),
+            _dot_constant_vector_3d(m_p[(x1y1 + 1) % p_size], xf - 1.0f,
+                                    yf - 1.0f, zf - 1.0f)))};
+
+  return _lerp(w, front, back);
+}
+
+#ifdef VULKANKRAFT_PERLIN_SIMD
+bool PerlinNoise::_get_batch(const float *x, const float *y, float *values,
+                             const float _freq, const int oct) const {
+  using namespace simd;
+
+  // Adding the offset never results in -0, so clearing the sign bit is the
+  // same as core::math::abs
+  const auto px{clear_sign(add(load(x), set(noise_offset)))};
+  const auto py{clear_sign(add(load(y), set(noise_offset)))};
+
+  auto sum{set(0.0f)};
+  float freq{_freq};
+  float amp{1.0f};
+
+  for (int i = 0; i < oct; i++) {
+    const auto xs{mul(px, set(freq))};
+    const auto ys{mul(py, set(freq))};
+
+    // The coordinates are positive, so truncating is the same as floorf
+    const auto xi{truncate(xs)};
+    const auto yi{truncate(ys)};
+    if (any_equal(xi, yi, INT32_MIN)) {
+      return false;
+    }
+
+    const auto xf{sub(xs, to_float(xi))};
+    const auto yf{sub(ys, to_float(yi))};
+    const auto xf1{sub(xf, set(1.0f))};
+    const auto yf1{sub(yf, set(1.0f))};
+
+    const auto mask{set(static_cast<int32_t>(noise_size - 1))};
+    const auto X{bit_and(xi, mask)};
+    const auto Y{bit_and(yi, mask)};
+
+    const auto left{add(gather(m_p.data(), X), Y)};
+    const auto right{add(gather(m_p.data(), add(X, set(1))), Y)};
+
+    const auto dot_bottom_left{
+        dot_gradient(gather(m_gradients.data(), left), xf, yf)};
+    const auto dot_top_left{
+        dot_gradient(gather(m_gradients.data(), add(left, set(1))), xf, yf1)};
+    const auto dot_bottom_right{
+        dot_gradient(gather(m_gradients.data(), right), xf1, yf)};
+    const auto dot_top_right{
+        dot_gradient(gather(m_gradients.data(), add(right, set(1))), xf1, yf1)};
+
+    const auto u{fade(xf)};
+    const auto v{fade(yf)};
+    const auto result{lerp(u, lerp(v, dot_bottom_left, dot_top_left),
+                           lerp(v, dot_bottom_right, dot_top_right))};
+
+    sum = add(sum, mul(result, set(amp)));
+    freq *= 2.0f;
+    amp /= 2.0f;
+  }
+
+  store(values, sum);
+  for (size_t l = 0; l < lane_count; l++) {
+    values[l] = _clamp(values[l], -1.0f, 1.0f);
+  }
+  return true;
+}
+#endif
 } // namespace world_gen
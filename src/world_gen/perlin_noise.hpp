@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
 
 namespace world_gen {
@@ -16,6 +17,26 @@ public:
   // returns a value between -1 and 1
   float get(const float x, const float y, const float freq = 0.005f,
             const int oct = 8) const;
+  // Get the noise values of a grid of width * height points starting at origin
+  // in one call. The value of the point origin + (i, j) is written into
+  // values[i + j * width]. The points are computed with SIMD if available and
+  // the values are the same as the ones of get
+  void get_grid(const glm::ivec2 &origin, const size_t width,
+                const size_t height, float *values, const float freq = 0.005f,
+                const int oct = 8) const;
+  // Get a 3D noise value
+  // returns a value between -1 and 1
+  float get_3d(const float x, const float y, const float z,
+               const float freq = 0.005f, const int oct = 8) const;
+  // Get the 3D noise values of a grid of size points starting at origin. The
+  // noise is only computed at the corners of cells of cell_size points and
+  // trilinearly interpolated in between. The size needs to be a multiple of
+  // cell_size. The value of the point origin + (x, y, z) is written into
+  // values[x + (z + y * size.z) * size.x]
+  void get_interpolated_grid(const glm::ivec3 &origin, const glm::ivec3 &size,
+                             const glm::ivec3 &cell_size, float *values,
+                             const float freq = 0.005f,
+                             const int oct = 8) const;
 
 private:
   // The size of the m_p array. Defines how diverse the noise is
@@ -38,6 +59,22 @@ private:
     }
   }
 
+  // Returns the dot product of (x, y, z) with one of the 12 vectors pointing
+  // from the center of a cube to the middle of its edges based on v
+  static inline float _dot_constant_vector_3d(const int v, const float x,
+                                              const float y, const float z) {
+    // A lookup is used instead of a switch since the branches could not be
+    // predicted
+    static constexpr float vectors[12][3]{
+        {1.0f, 1.0f, 0.0f},  {-1.0f, 1.0f, 0.0f},  {1.0f, -1.0f, 0.0f},
+        {-1.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 1.0f},  {-1.0f, 0.0f, 1.0f},
+        {1.0f, 0.0f, -1.0f},  {-1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 1.0f},
+        {0.0f, -1.0f, 1.0f},  {0.0f, 1.0f, -1.0f},  {0.0f, -1.0f, -1.0f},
+    };
+    const auto &vector{vectors[v % 12]};
+    return vector[0] * x + vector[1] * y + vector[2] * z;
+  }
+
   // Clamps v between min and max
   template <typename T>
   static inline auto _clamp(const T &v, const T &min, const T &max) {
@@ -60,7 +97,17 @@ private:
 
   // An internally noise function without Fractal Brownian Motion (FBM)
   float _get(float x, float y, const float freq) const;
+  // An internally 3D noise function without Fractal Brownian Motion (FBM)
+  float _get_3d(float x, float y, float z, const float freq) const;
+  // Computes get for a batch of points with SIMD. The amount of points depends
+  // on the instruction set. Only defined if SIMD is available. Returns false if
+  // a coordinate is too large for 32 bit integers
+  bool _get_batch(const float *x, const float *y, float *values,
+                  const float freq, const int oct) const;
 
-  std::array<size_t, noise_size + 1> m_p;
+  std::array<int32_t, noise_size + 1> m_p;
+  // m_gradients[i] = m_p[i % (noise_size + 1)] % 4. Lets the batched noise
+  // look up the gradients without the modulo
+  std::array<int32_t, noise_size * 2> m_gradients;
 };
 } // namespace world_gen
@@ -8,16 +8,82 @@
 #include "../../core/vulkan/context.hpp"
 #include "../../core/window.hpp"
 #include "../perlin_noise.hpp"
+#include <array>
+#include <cstring>
 #include <glm/gtx/transform.hpp>
 
 #include <shaders/perlin_noise_test_frag.hpp>
 #include <shaders/perlin_noise_test_vert.hpp>
 
+// Compares the values of get_grid with the values of get. They need to be
+// exactly the same, otherwise the worlds of existing seeds would change.
+// Returns wether all values are the same
+static bool run_verify() {
+  constexpr size_t width = 67;
+  constexpr size_t height = 13;
+  constexpr std::array<size_t, 4> seeds{1, 42, 1337, 123456789};
+  // With a frequency of 1 and 8 octaves the last origin pushes the
+  // coordinates past the range of 32 bit integers, which get_grid computes
+  // without SIMD
+  const std::array<glm::ivec2, 5> origins{
+      glm::ivec2(0, 0), glm::ivec2(-37, -1000), glm::ivec2(-64, 64),
+      glm::ivec2(1000003, -77), glm::ivec2(30000000, -30000000)};
+  constexpr std::array<float, 4> frequencies{0.005f, 0.02f, 0.1f, 1.0f};
+  constexpr std::array<int, 2> octaves{1, 8};
+
+  std::vector<float> grid(width * height);
+  std::vector<float> scalar(grid.size());
+  size_t failed_grids{0};
+  size_t grid_count{0};
+  for (const auto seed : seeds) {
+    world_gen::PerlinNoise noise;
+    noise.seed(seed);
+
+    for (const auto &origin : origins) {
+      for (const auto frequency : frequencies) {
+        for (const auto octave : octaves) {
+          noise.get_grid(origin, width, height, grid.data(), frequency,
+                         octave);
+          for (size_t j = 0; j < height; j++) {
+            for (size_t i = 0; i < width; i++) {
+              scalar[i + j * width] = noise.get(
+                  static_cast<float>(origin.x + static_cast<int>(i)),
+                  static_cast<float>(origin.y + static_cast<int>(j)),
+                  frequency, octave);
+            }
+          }
+
+          grid_count++;
+          if (std::memcmp(grid.data(), scalar.data(),
+                          sizeof(float) * grid.size()) != 0) {
+            failed_grids++;
+            core::Log::error(
+                "get_grid differs from get with seed " + std::to_string(seed) +
+                " at (" + std::to_string(origin.x) + "; " +
+                std::to_string(origin.y) + ") with frequency " +
+                std::to_string(frequency) + " and " + std::to_string(octave) +
+                " octaves");
+          }
+        }
+      }
+    }
+  }
+
+  core::Log::info(std::to_string(grid_count - failed_grids) + " of " +
+                  std::to_string(grid_count) +
+                  " grids are the same as the values of get");
+  return failed_grids == 0;
+}
+
 int main(int args, char *argv[]) {
   core::Settings settings;
   core::FPSTimer timer(settings.max_fps);
   world_gen::PerlinNoise noise;
 
+  if (args > 1 && std::strcmp(argv[1], "--verify") == 0) {
+    return run_verify() ? 0 : 1;
+  }
+
   try {
     core::Window window(settings.window_width, settings.window_height,
                         core::Settings::window_title);
@@ -1,7 +1,11 @@
 #include "world_generation.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
 
 namespace world_gen {
-WorldGeneration::WorldGeneration(const size_t seed_value) {
+WorldGeneration::WorldGeneration(const size_t seed_value)
+    : m_seed(seed_value) {
   if (seed_value != 0) {
     m_noise.seed(seed_value);
   }
@@ -9,32 +13,152 @@ WorldGeneration::WorldGeneration(const size_t seed_value) {
 
 void WorldGeneration::seed(const size_t seed_value) {
   m_noise.seed(seed_value);
+  m_seed = seed_value;
 }
 
 void WorldGeneration::generate(const glm::ivec2 &chunk_pos,
                                chunk::BlockArray &block_array) const {
+  generate_terrain(chunk_pos, block_array);
+  generate_surface(block_array);
+}
+
+void WorldGeneration::generate_terrain(const glm::ivec2 &chunk_pos,
+                                       chunk::BlockArray &block_array) const {
+  std::array<float, chunk::block_width * chunk::block_depth> noise_values;
+  _get_height_noise(chunk_pos, chunk::block_width, chunk::block_depth,
+                    noise_values.data());
+
+  const glm::ivec3 size(chunk::block_width, chunk::block_height,
+                        chunk::block_depth);
+  std::vector<float> density(size.x * size.y * size.z);
+  _get_density_noise(glm::ivec3(chunk_pos.x, 0, chunk_pos.y), size,
+                     density.data());
+
+  for (size_t x = 0; x < chunk::block_width; x++) {
+    for (size_t z = 0; z < chunk::block_depth; z++) {
+      const auto height{_to_height(noise_values[x + z * chunk::block_width])};
+      for (size_t y = 0; y < chunk::block_height; y++) {
+        block_array.set(x, y, z,
+                        _is_solid(height, y,
+                                  density[x + (z + y * size.z) * size.x])
+                            ? block::Type::DIRT
+                            : block::Type::AIR);
+      }
+    }
+  }
+}
+
+void WorldGeneration::generate_surface(chunk::BlockArray &block_array) const {
   for (size_t x = 0; x < chunk::block_width; x++) {
     for (size_t z = 0; z < chunk::block_depth; z++) {
-      const glm::vec2 block_pos(
-          static_cast<float>(chunk_pos.x) + static_cast<float>(x),
-          static_cast<float>(chunk_pos.y) + static_cast<float>(z));
-
-      auto noise_value{m_noise.get(block_pos.x, block_pos.y)};
-      noise_value += 1.0f;
-      noise_value /= 2.0f;
-      noise_value *= static_cast<float>(chunk::block_height);
-
-      const auto max_height{static_cast<size_t>(noise_value)};
-      if (max_height != 0) {
-        for (size_t y = 0; y < max_height - 1; y++) {
-          block_array.set(x, y, z, block::Type::DIRT);
-        }
-        block_array.set(x, max_height - 1, z, block::Type::GRASS);
+      if (const auto height{block_array.get_column_height(x, z)};
+          height != 0) {
+        block_array.set(x, height - 1, z, block::Type::GRASS);
       }
-      for (size_t y = max_height; y < chunk::block_height; y++) {
-        block_array.set(x, y, z, block::Type::AIR);
+    }
+  }
+}
+
+void WorldGeneration::get_heights(const glm::ivec2 &origin, const size_t width,
+                                  const size_t height, const int step,
+                                  size_t *heights) const {
+  // The height noise of all columns from the first to the last one is read at
+  // once
+  const auto noise_width{(width - 1) * step + 1};
+  const auto noise_height{(height - 1) * step + 1};
+  std::vector<float> noise_values(noise_width * noise_height);
+  _get_height_noise(origin, noise_width, noise_height, noise_values.data());
+
+  std::vector<size_t> column_heights(width * height);
+  for (size_t z = 0; z < height; z++) {
+    for (size_t x = 0; x < width; x++) {
+      column_heights[x + z * width] =
+          _to_height(noise_values[(x + z * noise_width) * step]);
+    }
+  }
+  const auto [min_height, max_height]{
+      std::minmax_element(column_heights.begin(), column_heights.end())};
+
+  // The 3D noise lies between -1 and 1, so the blocks more than
+  // density_squash blocks below the height of their column are solid and the
+  // blocks at least density_squash blocks above it are air. The noise is only
+  // computed for the cells in between. They start at a multiple of the cell
+  // size like the cells of the chunks
+  const auto align_down = [](const int v, const int cell_size) {
+    return v - (v % cell_size + cell_size) % cell_size;
+  };
+  const auto squash{static_cast<int>(density_squash)};
+  const glm::ivec3 density_origin(
+      align_down(origin.x, density_cell_width),
+      align_down(std::max(static_cast<int>(*min_height) - squash - 1, 0),
+                 density_cell_height),
+      align_down(origin.y, density_cell_width));
+  const glm::ivec3 density_end(
+      align_down(origin.x + static_cast<int>(noise_width) - 1,
+                 density_cell_width) +
+          density_cell_width,
+      std::min(align_down(static_cast<int>(*max_height) + squash - 1,
+                          density_cell_height) +
+                   density_cell_height,
+               chunk::block_height),
+      align_down(origin.y + static_cast<int>(noise_height) - 1,
+                 density_cell_width) +
+          density_cell_width);
+  const auto size{density_end - density_origin};
+  std::vector<float> density(size.x * size.y * size.z);
+  _get_density_noise(density_origin, size, density.data());
+
+  for (size_t z = 0; z < height; z++) {
+    for (size_t x = 0; x < width; x++) {
+      const auto column_height{column_heights[x + z * width]};
+      const auto column{
+          origin + glm::ivec2(static_cast<int>(x), static_cast<int>(z)) * step -
+          glm::ivec2(density_origin.x, density_origin.z)};
+      const auto density_at = [&](const int y) {
+        return density[column.x +
+                       (column.y + (y - density_origin.y) * size.z) * size.x];
+      };
+
+      // The block below the cells is always solid
+      auto y{density_end.y};
+      while (y != density_origin.y &&
+             !_is_solid(column_height, y - 1, density_at(y - 1))) {
+        y--;
       }
+      heights[x + z * width] = static_cast<size_t>(y);
     }
   }
 }
+
+void WorldGeneration::_get_height_noise(const glm::ivec2 &origin,
+                                        const size_t width,
+                                        const size_t height,
+                                        float *values) const {
+  // The noise of a whole region is computed at once which is a lot faster
+  // than computing every column on its own
+  m_noise_cache.get_grid(
+      m_seed, HEIGHT_LAYER, origin, width, height, values,
+      [this](const glm::ivec2 &region_origin, float *region_values) {
+        m_noise.get_grid(region_origin, NoiseCache::region_size,
+                         NoiseCache::region_size, region_values);
+      });
+}
+
+size_t WorldGeneration::_to_height(float noise_value) {
+  noise_value += 1.0f;
+  noise_value /= 2.0f;
+  noise_value *= static_cast<float>(chunk::block_height);
+
+  return static_cast<size_t>(noise_value);
+}
+
+void WorldGeneration::_get_density_noise(const glm::ivec3 &origin,
+                                         const glm::ivec3 &size,
+                                         float *values) const {
+  // Computing the 3D noise of every block would be far too slow
+  m_noise.get_interpolated_grid(
+      origin, size,
+      glm::ivec3(density_cell_width, density_cell_height, density_cell_width),
+      values, density_frequency, density_octaves);
+}
 } // namespace world_gen
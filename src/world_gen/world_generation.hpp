@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../chunk/block.hpp"
+#include "noise_cache.hpp"
 #include "perlin_noise.hpp"
 
 namespace world_gen {
@@ -10,10 +11,70 @@ public:
 
   void seed(const size_t seed_value);
 
+  // Generates the terrain and the surface of a chunk
   void generate(const glm::ivec2 &chunk_pos,
                 chunk::BlockArray &block_array) const;
+  // Fills a chunk with dirt where the density of the terrain is positive. The
+  // density falls off above the height of the terrain and is shifted by 3D
+  // noise which forms caves and overhangs near the surface
+  void generate_terrain(const glm::ivec2 &chunk_pos,
+                        chunk::BlockArray &block_array) const;
+  // Covers the highest block of every column with grass
+  void generate_surface(chunk::BlockArray &block_array) const;
+  // Writes the heights of width * height columns which lie step blocks apart
+  // into heights. The height of origin + (x, z) * step is written into
+  // heights[x + z * width]. It is the height of the highest solid block of
+  // the column in the generated chunks
+  void get_heights(const glm::ivec2 &origin, const size_t width,
+                   const size_t height, const int step,
+                   size_t *heights) const;
+
+  // Returns how often the noise of the terrain has been read from the cache
+  inline NoiseCache::Statistics get_noise_cache_statistics() const {
+    return m_noise_cache.get_statistics();
+  }
 
 private:
+  // The 3D noise is computed at the corners of cells of this size and
+  // interpolated in between
+  static constexpr int density_cell_width = 4;
+  static constexpr int density_cell_height = 8;
+  static constexpr float density_frequency = 0.03f;
+  static constexpr int density_octaves = 4;
+  // How many blocks above or below the height of the terrain the 3D noise
+  // can move the surface
+  static constexpr float density_squash = 24.0f;
+
+  // The noise layers stored in the noise cache
+  enum NoiseLayer {
+    HEIGHT_LAYER,
+  };
+
+  // Writes the height noise of width * height columns starting at origin into
+  // values. The value of origin + (x, z) is written into values[x + z * width]
+  void _get_height_noise(const glm::ivec2 &origin, const size_t width,
+                         const size_t height, float *values) const;
+  // Converts a noise value into the number of solid blocks of a column
+  static size_t _to_height(float noise_value);
+  // Writes the 3D noise of the blocks of size starting at origin into values.
+  // The value of origin + (x, y, z) is written into
+  // values[x + (z + y * size.z) * size.x]. The origin and the size need to be
+  // multiples of the cell size, so that every block gets the same value no
+  // matter which region it is computed with
+  void _get_density_noise(const glm::ivec3 &origin, const glm::ivec3 &size,
+                          float *values) const;
+  // Returns wether a block at y is solid in a column of the given height
+  static inline bool _is_solid(const size_t height, const size_t y,
+                               const float density_noise) {
+    return (static_cast<float>(height) - static_cast<float>(y)) /
+                   density_squash +
+               density_noise >
+           0.0f;
+  }
+
   PerlinNoise m_noise;
+  size_t m_seed;
+  // Chunks and the far terrain read the same regions of noise
+  mutable NoiseCache m_noise_cache;
 };
 } // namespace world_gen
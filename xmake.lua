@@ -102,10 +102,25 @@ target("resources")
             "fonts/*")
 target_end()
 
+option("profiler")
+  set_default(false)
+  set_showmenu(true)
+  set_description("Record profiler zones which can be exported as Chrome trace (F10)")
+  add_defines("VULKANKRAFT_PROFILER")
+option_end()
+
+option("avx2")
+  set_default(false)
+  set_showmenu(true)
+  set_description("Compile with AVX2 which speeds up the noise of the world generation")
+  add_vectorexts("avx2")
+option_end()
+
 add_rules("mode.debug", "mode.release")
 target("core")
   set_kind("static")
   set_languages("cxx17")
+  add_options("profiler")
   add_deps("resources")
   add_packages("glfw", "glm", "stb", "vulkan-hpp", "nlohmann_json", "libcurl")
   if is_plat("windows") then
@@ -135,6 +150,7 @@ target("core")
 target("vulkankraft")
   set_kind("binary")
   set_languages("cxx17")
+  add_options("profiler", "avx2")
   add_deps("core")
   add_packages("glfw", "glm", "stb", "vulkan-hpp")
 
@@ -158,6 +174,7 @@ target("perlin_noise_test")
   set_enabled(is_mode("debug"))
   set_kind("binary")
   set_languages("cxx17")
+  add_options("avx2")
   add_deps("core")
   add_packages("glfw", "glm", "stb", "vulkan-hpp")
 
@@ -181,9 +198,9 @@ target("physics_test")
   set_languages("cxx17")
   add_packages("glm")
 
-  add_files("src/physics/aabb.cpp",
+  add_files("src/physics/aabb.cpp", "src/physics/frustum.cpp",
             "src/physics/physics_test/main.cpp")
-  add_headerfiles("src/physics/aabb.hpp")
+  add_headerfiles("src/physics/aabb.hpp", "src/physics/frustum.hpp")
 
 target("gui_test")
   set_enabled(is_mode("debug"))
@@ -193,3 +210,17 @@ target("gui_test")
   add_packages("glfw", "glm", "stb", "vulkan-hpp")
 
   add_files("src/core/gui/gui_test/main.cpp")
+
+target("chunk_benchmark")
+  set_kind("binary")
+  set_languages("cxx17")
+  add_options("profiler", "avx2")
+  add_deps("core")
+  add_packages("glfw", "glm", "stb", "vulkan-hpp", "nlohmann_json")
+
+  add_files("src/chunk/*.cpp",
+            "src/block/*.cpp",
+            "src/world_gen/*.cpp",
+            "src/physics/*.cpp",
+            "src/save/*.cpp",
+            "src/chunk/chunk_benchmark/*.cpp")